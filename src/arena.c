@@ -0,0 +1,89 @@
+/**
+ * Bump allocation arenas
+ *
+ * Allocations are never freed individually; the whole arena is reset at
+ * once. An arena that overflows chains on another block, and the next
+ * reset folds everything back into a single block big enough for the lot,
+ * so a reused arena stops allocating once it has seen its largest job.
+ *
+ * @file arena.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include "dass.h"
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 16
+
+struct ArenaBlock
+{
+    ArenaBlock *next;
+    size_t used;
+    size_t size;
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+};
+
+static ArenaBlock *newBlock(const size_t size, ArenaBlock *next);
+
+void arenaInit(Arena *arena, const size_t capacity)
+{
+    arena->capacity = capacity > 0 ? capacity : ARENA_ALIGNMENT;
+    arena->blocks = newBlock(arena->capacity, NULL);
+}
+
+void arenaFree(Arena *arena)
+{
+    while (arena->blocks != NULL)
+    {
+        ArenaBlock *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+
+    arena->capacity = 0;
+}
+
+void arenaReset(Arena *arena)
+{
+    if (arena->blocks->next != NULL)
+    {
+        size_t capacity = arena->capacity;
+        arenaFree(arena);
+        arenaInit(arena, capacity);
+        return;
+    }
+
+    arena->blocks->used = 0;
+}
+
+void *arenaAlloc(Arena *arena, const size_t size)
+{
+    size_t rounded =
+        (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    ArenaBlock *block = arena->blocks;
+
+    if (block->size - block->used < rounded)
+    {
+        size_t blockSize =
+            block->size * 2 > rounded ? block->size * 2 : rounded;
+        block = arena->blocks = newBlock(blockSize, block);
+
+        // Remember the total so a reset can fold it into one block.
+        arena->capacity += blockSize;
+    }
+
+    void *pointer = block->data + block->used;
+    block->used += rounded;
+
+    return pointer;
+}
+
+static ArenaBlock *newBlock(const size_t size, ArenaBlock *next)
+{
+    ArenaBlock *block = safe_malloc(sizeof(ArenaBlock) + size);
+    block->next = next;
+    block->used = 0;
+    block->size = size;
+    return block;
+}
@@ -0,0 +1,27 @@
+/**
+ * Bump allocation arenas
+ *
+ * @file arena.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena
+{
+    ArenaBlock *blocks;
+    size_t capacity;
+} Arena;
+
+void arenaInit(Arena *arena, const size_t capacity);
+void arenaFree(Arena *arena);
+void arenaReset(Arena *arena);
+void *arenaAlloc(Arena *arena, const size_t size);
+
+#endif
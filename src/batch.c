@@ -0,0 +1,458 @@
+/**
+ * Parallel processing of many traces
+ *
+ * Traces are handed out one at a time to a pool of worker threads. Each
+ * worker reads, parses and simulates a trace entirely inside its own arena,
+ * which is reset rather than freed between traces. Per-chunk output is
+ * skipped; only the summary of each trace makes it into the report, which
+ * is written as JSON once every trace is done. A trace that fails still
+ * gets its entry in the report, but fails the batch as a whole.
+ *
+ * With D_RESULT_CACHE set, scheduler results are memoised on disk, and a
+ * trace whose every result is already known is not simulated at all.
+ *
+ * @file batch.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "arena.h"
+#include "statcache.h"
+#include "memo.h"
+#include "parse.h"
+#include "batch.h"
+
+#define ARENA_SIZE (1 << 20)
+
+typedef struct TraceResult
+{
+    char *path;
+    bool ok;
+    const char *error;
+    int requests;
+    long invalid[INVALID_KINDS];
+    double mean;
+    double stddev;
+    double seconds;
+    SchedulerState states[SCHEDULERS_MAX];
+    int reversals;
+} TraceResult;
+
+typedef struct BatchJob
+{
+    TraceResult *results;
+    int count;
+    int next;
+
+    ResultCache cache;
+    bool memoise;
+} BatchJob;
+
+static char **collectPaths(const char *source, int *count);
+static int comparePaths(const void *a, const void *b);
+static void *worker(void *argument);
+static void runTrace(Arena *arena, TraceResult *result, BatchJob *job);
+static void simulate(SeekList seeks, TraceResult *result, BatchJob *job,
+                     const uint64_t trace);
+static void writeReport(FILE *out, const BatchJob *job, const int threads,
+                        const double seconds);
+static void writeString(FILE *out, const char *text);
+static void writeStates(FILE *out, const SchedulerState states[]);
+
+bool batch(const char *source, const char *reportPath)
+{
+    int count;
+    char **paths = collectPaths(source, &count);
+
+    if (paths == NULL)
+        return false;
+
+    BatchJob job = {
+        .results = safe_malloc(sizeof(TraceResult) * (count > 0 ? count : 1)),
+        .count = count,
+    };
+
+    job.memoise = resultCacheInit(&job.cache);
+
+    for (int i = 0; i < count; i++)
+        job.results[i] = (TraceResult){.path = paths[i]};
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = envLong("D_THREADS", online > 0 ? online : 1);
+    threads = min(threads, count);
+    if (threads < 1)
+        threads = 1;
+
+    pthread_t *workers = safe_malloc(sizeof(pthread_t) * threads);
+    double began = monotonicSeconds();
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&workers[i], NULL, worker, &job);
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+
+    double seconds = monotonicSeconds() - began;
+
+    FILE *out = stdout;
+    if (reportPath != NULL && (out = fopen(reportPath, "w")) == NULL)
+    {
+        fprintf(stderr, "Could not open report: %s\n", reportPath);
+        out = stdout;
+    }
+
+    writeReport(out, &job, threads, seconds);
+
+    // Any trace that couldn't be read or parsed fails the batch.
+    bool ok = true;
+    for (int i = 0; i < count; i++)
+        ok = ok && job.results[i].ok;
+
+    if (out != stdout && fclose(out) != 0)
+    {
+        fprintf(stderr, "Could not write report: %s\n", reportPath);
+        ok = false;
+    }
+
+    for (int i = 0; i < count; i++)
+        free(paths[i]);
+    free(paths);
+    free(job.results);
+    free(workers);
+
+    return ok;
+}
+
+static char **collectPaths(const char *source, int *count)
+{
+    int size = D_DYNAMIC_BASE_SIZE;
+    char **paths = safe_malloc(sizeof(char *) * size);
+    *count = 0;
+
+    struct stat info;
+    if (stat(source, &info) != 0)
+    {
+        fprintf(stderr, "Could not open: %s\n", source);
+        free(paths);
+        return NULL;
+    }
+
+    if (S_ISDIR(info.st_mode))
+    {
+        // Every regular, non-hidden file in the directory
+        DIR *directory = opendir(source);
+        struct dirent *entry;
+
+        while (directory != NULL && (entry = readdir(directory)) != NULL)
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+
+            char *path =
+                safe_malloc(strlen(source) + strlen(entry->d_name) + 2);
+            sprintf(path, "%s/%s", source, entry->d_name);
+
+            if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+            {
+                free(path);
+                continue;
+            }
+
+            if (*count == size)
+            {
+                size *= 2;
+                paths = safe_realloc(paths, sizeof(char *) * size);
+            }
+            paths[(*count)++] = path;
+        }
+
+        if (directory != NULL)
+            closedir(directory);
+
+        qsort(paths, *count, sizeof(char *), comparePaths);
+    }
+    else
+    {
+        // One path per line
+        FILE *list = fopen(source, "r");
+        char *line = NULL;
+        size_t capacity = 0;
+        ssize_t length;
+
+        while (list != NULL &&
+               (length = getline(&line, &capacity, list)) != -1)
+        {
+            while (length > 0 &&
+                   (line[length - 1] == '\n' || line[length - 1] == '\r'))
+                line[--length] = '\0';
+
+            if (length == 0)
+                continue;
+
+            if (*count == size)
+            {
+                size *= 2;
+                paths = safe_realloc(paths, sizeof(char *) * size);
+            }
+            paths[(*count)++] = strdup(line);
+        }
+
+        free(line);
+        if (list != NULL)
+            fclose(list);
+    }
+
+    return paths;
+}
+
+static int comparePaths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void *worker(void *argument)
+{
+    BatchJob *job = argument;
+
+    Arena arena;
+    arenaInit(&arena, ARENA_SIZE);
+
+    for (;;)
+    {
+        int index = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+
+        if (index >= job->count)
+            break;
+
+        arenaReset(&arena);
+        runTrace(&arena, &job->results[index], job);
+    }
+
+    arenaFree(&arena);
+
+    return NULL;
+}
+
+static void runTrace(Arena *arena, TraceResult *result, BatchJob *job)
+{
+    double began = monotonicSeconds();
+
+    int fd = open(result->path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        result->error = strerror(errno);
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    // Read the whole trace into the arena.
+    size_t size = info.st_size;
+    char *text = arenaAlloc(arena, size + 1);
+    size_t done = 0;
+
+    while (done < size)
+    {
+        ssize_t got = read(fd, text + done, size - done);
+        if (got <= 0)
+            break;
+        done += got;
+    }
+
+    close(fd);
+    text[done] = '\0';
+
+    // Every seek takes at least a digit and a separator.
+    int *seeks = arenaAlloc(arena, sizeof(int) * (done / 2 + 1));
+    Validation validation;
+    validationInit(&validation);
+    int length = parseSeekText(text, text + done, seeks, &validation);
+    memcpy(result->invalid, validation.counts, sizeof(validation.counts));
+
+    if (validation.failed)
+    {
+        result->error = "invalid seek";
+        return;
+    }
+
+    uint64_t trace = job->memoise ? hashBytes(text, done, HASH_SEED) : 0;
+    simulate((SeekList){seeks, length}, result, job, trace);
+
+    // processInChunks() works on a copy, so the trace is still in order.
+    double sum = 0;
+    for (int i = 0; i < length; i++)
+        sum += seeks[i];
+
+    double mean = length > 0 ? sum / length : 0;
+    double sumOfDeviations = 0;
+    for (int i = 0; i < length; i++)
+        sumOfDeviations += (seeks[i] - mean) * (seeks[i] - mean);
+
+    result->ok = true;
+    result->requests = length;
+    result->mean = mean;
+    result->stddev = length > 0 ? sqrt(sumOfDeviations / length) : 0;
+    result->seconds = monotonicSeconds() - began;
+}
+
+static void simulate(SeekList seeks, TraceResult *result, BatchJob *job,
+                     const uint64_t trace)
+{
+    Simulation sim;
+    simulationInit(&sim);
+    sim.quiet = true;
+
+    // The schedulers share each chunk's buffer in turn, so one missing
+    // result means running them all.
+    bool known = job->memoise;
+    MemoResult memo[SCHEDULERS_MAX];
+
+    for (int i = 0; known && i < schedulerCount; i++)
+        known = resultCacheLoad(&job->cache, trace, &sim, i, &memo[i]);
+
+    // Counted by whether the results were used, not by what was found
+    if (job->memoise)
+        resultCacheCount(&job->cache, known, schedulerCount);
+
+    if (known)
+    {
+        for (int i = 0; i < schedulerCount; i++)
+        {
+            result->states[i] = memo[i].state;
+            result->reversals += memo[i].reversals;
+        }
+        return;
+    }
+
+    // Results are keyed by the configuration they started from.
+    Simulation initial = sim;
+    processInChunks(&sim, seeks);
+
+    memcpy(result->states, sim.states, sizeof(sim.states));
+    result->reversals = sim.elevatorReversals;
+
+    for (int i = 0; job->memoise && i < schedulerCount; i++)
+    {
+        memo[i] = (MemoResult){
+            .state = sim.states[i],
+            .reversals = streq(schedulers[i].key, "elevator")
+                             ? sim.elevatorReversals
+                             : 0,
+        };
+        resultCacheStore(&job->cache, trace, &initial, i, &memo[i]);
+    }
+
+    simulationFree(&sim);
+}
+
+static void writeReport(FILE *out, const BatchJob *job, const int threads,
+                        const double seconds)
+{
+    const TraceResult *results = job->results;
+    const int count = job->count;
+
+    SchedulerState totals[SCHEDULERS_MAX] = {0};
+    long requests = 0;
+    int failed = 0;
+
+    fprintf(out, "{\n  \"traces\": [");
+
+    for (int i = 0; i < count; i++)
+    {
+        const TraceResult *result = &results[i];
+
+        fprintf(out, "%s\n    {\"path\": ", i > 0 ? "," : "");
+        writeString(out, result->path);
+
+        if (!result->ok)
+        {
+            failed++;
+            fprintf(out, ", \"ok\": false, \"error\": ");
+            writeString(out, result->error);
+            fprintf(out, "}");
+            continue;
+        }
+
+        requests += result->requests;
+        for (int j = 0; j < schedulerCount; j++)
+        {
+            totals[j].tally += result->states[j].tally;
+            totals[j].distance += result->states[j].distance;
+        }
+
+        fprintf(out,
+                ", \"ok\": true, \"requests\": %d, \"out_of_range\": %ld, "
+                "\"non_numeric\": %ld, \"overflow\": %ld, "
+                "\"mean\": %.4f, \"stddev\": %.4f, \"seconds\": %.6f, "
+                "\"elevator_reversals\": %d, ",
+                result->requests, result->invalid[INVALID_RANGE],
+                result->invalid[INVALID_NUMBER],
+                result->invalid[INVALID_OVERFLOW], result->mean,
+                result->stddev, result->seconds, result->reversals);
+        writeStates(out, result->states);
+        fprintf(out, "}");
+    }
+
+    fprintf(out,
+            "\n  ],\n"
+            "  \"aggregate\": {\"traces\": %d, \"failed\": %d, "
+            "\"requests\": %ld, \"threads\": %d, \"seconds\": %.6f, ",
+            count, failed, requests, threads, seconds);
+
+    if (job->memoise)
+    {
+        fprintf(out, "\"result_cache\": {\"hits\": %ld, \"misses\": %ld}, ",
+                job->cache.hits, job->cache.misses);
+    }
+
+    writeStates(out, totals);
+    fprintf(out, "}\n}\n");
+}
+
+static void writeString(FILE *out, const char *text)
+{
+    fputc('"', out);
+
+    for (; *text != '\0'; text++)
+    {
+        unsigned char c = *text;
+
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+
+    fputc('"', out);
+}
+
+static void writeStates(FILE *out, const SchedulerState states[])
+{
+    fprintf(out, "\"schedulers\": {");
+
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        fprintf(out, "%s\"%s\": {\"tally\": %d, \"distance\": %ld}",
+                i > 0 ? ", " : "", schedulers[i].key, states[i].tally,
+                states[i].distance);
+    }
+
+    fprintf(out, "}");
+}
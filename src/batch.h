@@ -0,0 +1,16 @@
+/**
+ * Parallel processing of many traces
+ *
+ * @file batch.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+
+bool batch(const char *source, const char *reportPath);
+
+#endif
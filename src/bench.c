@@ -0,0 +1,135 @@
+/**
+ * Benchmark suite
+ *
+ * Timings are wall-clock and meant for comparing builds on one machine,
+ * not for quoting.
+ *
+ * @file bench.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dass.h"
+#include "engine.h"
+#include "loop.h"
+#include "bench.h"
+
+#define BENCH_HOLDS 2000000
+#define BENCH_SCHEDULED 200000
+#define BENCH_INCREMENTS 4096
+
+static void benchEventQueue(const int size);
+static void benchScheduler(const int scheduler, const int chunkSize);
+static void benchClosedLoop(const int clients);
+
+void runBenchmarks(void)
+{
+    srand(time(NULL));
+
+    printHeader("Event queue (hold model)");
+    benchEventQueue(16);
+    benchEventQueue(1024);
+    benchEventQueue(65536);
+    benchEventQueue(1048576);
+
+    printHeader("Schedulers");
+    for (int i = 0; i < schedulerCount; i++)
+        benchScheduler(i, 20);
+    for (int i = 0; i < schedulerCount; i++)
+        benchScheduler(i, 1000);
+
+    printHeader("Closed loop");
+    benchClosedLoop(64);
+    benchClosedLoop(65536);
+
+    printf("\n");
+}
+
+static void benchEventQueue(const int size)
+{
+    EventQueue queue;
+    eventQueueInit(&queue, size);
+
+    for (int i = 0; i < size; i++)
+        eventQueuePush(&queue, rand() / (double)RAND_MAX, i, 0);
+
+    // Draw the intervals up front so rand() stays out of the timing.
+    static double increments[BENCH_INCREMENTS];
+    for (int i = 0; i < BENCH_INCREMENTS; i++)
+        increments[i] = rand() / (double)RAND_MAX;
+
+    // Each hold pops the earliest event and schedules it again a random
+    // interval later, which keeps the queue at a steady size.
+    Event event;
+    double began = monotonicSeconds();
+
+    for (int i = 0; i < BENCH_HOLDS; i++)
+    {
+        eventQueuePop(&queue, &event);
+        eventQueuePush(&queue,
+                       event.time + increments[i % BENCH_INCREMENTS],
+                       event.index, event.kind);
+    }
+
+    double elapsed = monotonicSeconds() - began;
+
+    printf("%8d events: %8.1f ns per hold\n", size,
+           elapsed / BENCH_HOLDS * 1e9);
+
+    eventQueueFree(&queue);
+}
+
+static void benchScheduler(const int scheduler, const int chunkSize)
+{
+    Simulation sim;
+    simulationInit(&sim);
+
+    int *source = safe_malloc(sizeof(int) * chunkSize);
+    int *list = safe_malloc(sizeof(int) * chunkSize);
+
+    for (int i = 0; i < chunkSize; i++)
+        source[i] = randint(D_SIZE_MIN, D_SIZE_MAX);
+
+    int rounds = BENCH_SCHEDULED / chunkSize;
+    double elapsed = 0;
+
+    for (int round = 0; round < rounds; round++)
+    {
+        memcpy(list, source, sizeof(int) * chunkSize);
+        SeekList seeks = {list, chunkSize};
+
+        double began = monotonicSeconds();
+        schedulers[scheduler].schedule(&sim, &sim.states[scheduler], &seeks);
+        elapsed += monotonicSeconds() - began;
+    }
+
+    printf("%s (chunks of %d): %.1f ns per request\n",
+           schedulers[scheduler].title, chunkSize,
+           elapsed / (rounds * (double)chunkSize) * 1e9);
+
+    simulationFree(&sim);
+    free(list);
+    free(source);
+}
+
+static void benchClosedLoop(const int clients)
+{
+    LoopConfig config = loopConfigFromEnv(clients);
+    config.requests = 1000000;
+
+    EventQueue queue;
+    eventQueueInit(&queue, clients + 1);
+
+    double began = monotonicSeconds();
+    LoopResult result = runClosedLoop(&config, LOOP_ELEVATOR, &queue);
+    double elapsed = monotonicSeconds() - began;
+
+    eventQueueFree(&queue);
+
+    printf("%d clients: %.0f events per second\n", clients,
+           result.events / elapsed);
+}
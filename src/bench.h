@@ -0,0 +1,14 @@
+/**
+ * Benchmark suite
+ *
+ * @file bench.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+void runBenchmarks(void);
+
+#endif
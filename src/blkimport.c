@@ -0,0 +1,311 @@
+/**
+ * Import of block-layer traces
+ *
+ * Reads either the text that blkparse prints or the binary records that
+ * blktrace writes, telling them apart by the binary magic number. Only one
+ * kind of event is kept (queue events by default, set with D_BLK_ACTION),
+ * and each one's sector is mapped onto a cylinder using D_CYL_SECTORS
+ * sectors per cylinder. Timestamps, direction and size travel with the
+ * cylinders.
+ *
+ * @file blkimport.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <byteswap.h>
+#include <linux/blktrace_api.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "blkimport.h"
+
+#define SECTOR_SIZE 512
+#define MAGIC_MASK 0xffffff00u
+
+static int actionCode(const char letter);
+static bool toRequest(BlkReader *reader, const unsigned long long sector,
+                      const unsigned int bytes, const double time,
+                      const RequestOp op, Request *request);
+static bool nextBinary(BlkReader *reader, Request *request);
+static bool nextText(BlkReader *reader, Request *request);
+static bool parseLine(BlkReader *reader, const char *line, Request *request);
+
+bool blkReaderOpen(BlkReader *reader, FILE *stream)
+{
+    const char *action = getenv("D_BLK_ACTION");
+
+    *reader = (BlkReader){
+        .stream = stream,
+        .action = actionCode(action != NULL ? action[0] : 'Q'),
+        .sectorsPerCylinder = envLong("D_CYL_SECTORS", D_CYL_SECTORS),
+        .first = true,
+    };
+
+    if (reader->action == 0)
+    {
+        fprintf(stderr, "Unsupported blktrace action: %s\n", action);
+        return false;
+    }
+
+    if (reader->sectorsPerCylinder < 1)
+    {
+        fprintf(stderr, "Invalid sectors per cylinder.\n");
+        return false;
+    }
+
+    // Peek at the start of the stream to tell binary from text.
+    unsigned int magic = 0;
+    size_t got = fread(&magic, 1, sizeof(magic), stream);
+
+    if (got == sizeof(magic) && ((magic & MAGIC_MASK) == BLK_IO_TRACE_MAGIC ||
+                                 (bswap_32(magic) & MAGIC_MASK) ==
+                                     BLK_IO_TRACE_MAGIC))
+    {
+        // Traces are written in the recording machine's byte order.
+        reader->binary = true;
+        reader->swapped = (magic & MAGIC_MASK) != BLK_IO_TRACE_MAGIC;
+        reader->magic = magic;
+    }
+    else
+    {
+        memcpy(reader->peeked, &magic, got);
+        reader->peekedLength = got;
+    }
+
+    return true;
+}
+
+bool blkReaderNext(BlkReader *reader, Request *request)
+{
+    return reader->binary ? nextBinary(reader, request)
+                          : nextText(reader, request);
+}
+
+void blkReaderClose(BlkReader *reader)
+{
+    free(reader->line);
+    reader->line = NULL;
+
+    if (reader->skipped > 0)
+        fprintf(stderr, "\nRequests beyond the last cylinder: %ld\n\n",
+                reader->skipped);
+}
+
+bool importBlktrace(FILE *stream, RequestTable *requests)
+{
+    BlkReader reader;
+
+    if (!blkReaderOpen(&reader, stream))
+        return false;
+
+    requestTableAddColumns(requests,
+                           REQUEST_ARRIVAL | REQUEST_OP | REQUEST_SIZE);
+
+    Request request;
+
+    while (blkReaderNext(&reader, &request))
+    {
+        long row = requestTableAppend(requests, request.cylinder);
+        requests->arrival[row] = request.arrival;
+        requests->op[row] = request.op;
+        requests->size[row] = request.size;
+    }
+
+    blkReaderClose(&reader);
+
+    return !reader.failed;
+}
+
+static int actionCode(const char letter)
+{
+    switch (letter)
+    {
+    case 'Q':
+        return __BLK_TA_QUEUE;
+    case 'G':
+        return __BLK_TA_GETRQ;
+    case 'I':
+        return __BLK_TA_INSERT;
+    case 'D':
+        return __BLK_TA_ISSUE;
+    case 'C':
+        return __BLK_TA_COMPLETE;
+    default:
+        return 0;
+    }
+}
+
+static bool toRequest(BlkReader *reader, const unsigned long long sector,
+                      const unsigned int bytes, const double time,
+                      const RequestOp op, Request *request)
+{
+    unsigned long long cylinder =
+        sector / reader->sectorsPerCylinder + D_SIZE_MIN;
+
+    if (cylinder > D_SIZE_MAX)
+    {
+        reader->skipped++;
+        return false;
+    }
+
+    *request = (Request){
+        .cylinder = (int)cylinder,
+        .arrival = time,
+        .op = op,
+        .size = bytes,
+    };
+
+    return true;
+}
+
+static bool nextBinary(BlkReader *reader, Request *request)
+{
+    struct blk_io_trace record;
+    char skip[256];
+
+    for (;;)
+    {
+        // The first record's magic has already been read.
+        size_t offset = 0;
+
+        if (reader->first)
+        {
+            record.magic = reader->magic;
+            offset = sizeof(record.magic);
+            reader->first = false;
+        }
+
+        size_t got = fread((char *)&record + offset, 1,
+                           sizeof(record) - offset, reader->stream);
+
+        // Only a clean break between records is the end of the trace.
+        if (got != sizeof(record) - offset)
+        {
+            if (got > 0 || offset > 0 || ferror(reader->stream))
+            {
+                fprintf(stderr, "Truncated blktrace record.\n");
+                reader->failed = true;
+            }
+            return false;
+        }
+
+        if (reader->swapped)
+        {
+            record.magic = bswap_32(record.magic);
+            record.time = bswap_64(record.time);
+            record.sector = bswap_64(record.sector);
+            record.bytes = bswap_32(record.bytes);
+            record.action = bswap_32(record.action);
+            record.pdu_len = bswap_16(record.pdu_len);
+        }
+
+        if ((record.magic & MAGIC_MASK) != BLK_IO_TRACE_MAGIC)
+        {
+            fprintf(stderr, "Corrupt blktrace record.\n");
+            reader->failed = true;
+            return false;
+        }
+
+        // Skip the payload (process names, messages, cgroup IDs).
+        for (unsigned int left = record.pdu_len; left > 0;)
+        {
+            size_t step = left < sizeof(skip) ? left : sizeof(skip);
+            if (fread(skip, 1, step, reader->stream) != step)
+            {
+                fprintf(stderr, "Truncated blktrace record.\n");
+                reader->failed = true;
+                return false;
+            }
+            left -= step;
+        }
+
+        unsigned int category = record.action >> BLK_TC_SHIFT;
+
+        if (category & BLK_TC_NOTIFY ||
+            (int)(record.action & 0xffff) != reader->action ||
+            record.bytes == 0)
+            continue;
+
+        RequestOp op = category & BLK_TC_WRITE  ? OP_WRITE
+                       : category & BLK_TC_READ ? OP_READ
+                                                : OP_UNKNOWN;
+
+        if (toRequest(reader, record.sector, record.bytes, record.time / 1e9,
+                      op, request))
+            return true;
+    }
+}
+
+static bool nextText(BlkReader *reader, Request *request)
+{
+    ssize_t length;
+
+    while ((length = getline(&reader->line, &reader->capacity,
+                             reader->stream)) != -1 ||
+           reader->peekedLength > 0)
+    {
+        char *line = reader->line;
+        char *joined = NULL;
+
+        // Put the peeked bytes back in front of the first line.
+        if (reader->peekedLength > 0)
+        {
+            size_t rest = length > 0 ? length : 0;
+            joined = safe_malloc(reader->peekedLength + rest + 1);
+            memcpy(joined, reader->peeked, reader->peekedLength);
+            memcpy(joined + reader->peekedLength, reader->line, rest);
+            joined[reader->peekedLength + rest] = '\0';
+            reader->peekedLength = 0;
+            line = joined;
+        }
+
+        bool found = parseLine(reader, line, request);
+        free(joined);
+
+        if (found)
+            return true;
+    }
+
+    if (ferror(reader->stream))
+    {
+        fprintf(stderr, "Could not read blktrace text.\n");
+        reader->failed = true;
+    }
+
+    return false;
+}
+
+static bool parseLine(BlkReader *reader, const char *line, Request *request)
+{
+    if (line == NULL)
+        return false;
+
+    // Default blkparse layout:
+    // dev cpu sequence time pid action rwbs sector + sectors [process]
+    unsigned int major, minor, cpu, pid;
+    unsigned long sequence;
+    double time;
+    char action[4], rwbs[16];
+    unsigned long long sector;
+    unsigned int sectors;
+
+    int fields = sscanf(line, " %u,%u %u %lu %lf %u %3s %15s %llu + %u",
+                        &major, &minor, &cpu, &sequence, &time, &pid, action,
+                        rwbs, &sector, &sectors);
+
+    // Anything else is a summary line, a message or a data-less event.
+    if (fields != 10 || action[1] != '\0' ||
+        actionCode(action[0]) != reader->action || sectors == 0)
+        return false;
+
+    RequestOp op = strchr(rwbs, 'W')   ? OP_WRITE
+                   : strchr(rwbs, 'R') ? OP_READ
+                                       : OP_UNKNOWN;
+
+    return toRequest(reader, sector, sectors * SECTOR_SIZE, time, op,
+                     request);
+}
@@ -0,0 +1,45 @@
+/**
+ * Import of block-layer traces
+ *
+ * @file blkimport.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef BLKIMPORT_H
+#define BLKIMPORT_H
+
+#include <stdio.h>
+
+#include "requests.h"
+
+// Pulls one request at a time out of a blktrace or blkparse stream.
+typedef struct BlkReader
+{
+    FILE *stream;
+    int action;
+    long sectorsPerCylinder;
+    long skipped;
+
+    // The stream ended in a corrupt or cut-off record, or a read error,
+    // rather than at its end.
+    bool failed;
+
+    bool binary;
+    bool swapped;
+    bool first;
+    unsigned int magic;
+
+    char *line;
+    size_t capacity;
+    char peeked[4];
+    size_t peekedLength;
+} BlkReader;
+
+bool blkReaderOpen(BlkReader *reader, FILE *stream);
+bool blkReaderNext(BlkReader *reader, Request *request);
+void blkReaderClose(BlkReader *reader);
+
+bool importBlktrace(FILE *stream, RequestTable *requests);
+
+#endif
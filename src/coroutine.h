@@ -0,0 +1,33 @@
+/**
+ * Stackless coroutines
+ *
+ * A coroutine is an ordinary function whose resume point is kept in an
+ * integer owned by the caller. Anything that must survive a yield has to
+ * live outside the function, since locals are lost on every return.
+ *
+ * @file coroutine.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#define CO_BEGIN(line) \
+    switch (line)      \
+    {                  \
+    case 0:
+
+#define CO_YIELD(line)     \
+    do                     \
+    {                      \
+        (line) = __LINE__; \
+        return;            \
+    case __LINE__:;        \
+    } while (0)
+
+#define CO_END(line) \
+    }                \
+    (line) = 0
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * Shared definitions for the disk seeking simulation
+ *
+ * @file dass.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef DASS_H
+#define DASS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define D_SIZE_MIN 0
+#define D_SIZE_MAX 65535
+#define D_POS_INIT 32767
+#define CHUNK true
+#define D_CHUNK_SIZE 20
+#define D_BUFFER_SIZE 100
+
+// Geometry used to turn sector numbers into cylinders
+#define D_CYL_SECTORS 2048
+
+#define D_DYNAMIC_BASE_SIZE 10
+
+#define safe_malloc(size) _safe_malloc(size, __FILE__, __LINE__)
+#define safe_realloc(ptr, size) _safe_realloc(ptr, size, __FILE__, __LINE__)
+
+typedef struct SeekList
+{
+    int *list;
+    int length;
+} SeekList;
+
+typedef enum ElevatorPolicy
+{
+    ELEVATOR_UP,
+    ELEVATOR_NEARER,
+    ELEVATOR_DENSER
+} ElevatorPolicy;
+
+// Seek distances counted by power of two: bucket i holds 2^i to 2^(i+1) - 1
+// cylinders, and the last one anything longer.
+#define DISTANCE_BUCKETS 16
+
+// Where one algorithm's head sits and how far it has travelled so far
+typedef struct SchedulerState
+{
+    int start;
+    int tally;
+    long distance;
+    long buckets[DISTANCE_BUCKETS];
+} SchedulerState;
+
+typedef struct Simulation Simulation;
+typedef struct Writer Writer;
+typedef struct SeekHistogram SeekHistogram;
+
+typedef struct Scheduler
+{
+    const char *title;
+    const char *key;
+    void (*schedule)(Simulation *sim, SchedulerState *state, SeekList *seeks);
+} Scheduler;
+
+#define BUILTIN_SCHEDULERS 3
+
+// Built-ins plus room for schedulers loaded from plugins
+#define SCHEDULERS_MAX 8
+
+// One chunk as it arrived and as each scheduler left it
+typedef struct ChunkResult
+{
+    int seeks[D_CHUNK_SIZE];
+    int length;
+    int starts[SCHEDULERS_MAX];
+    int orders[SCHEDULERS_MAX][D_CHUNK_SIZE];
+} ChunkResult;
+
+// Everything one run carries from chunk to chunk
+struct Simulation
+{
+    SchedulerState states[SCHEDULERS_MAX];
+
+    // Elevator sweep direction
+    bool elevatorUp;
+    bool elevatorStarted;
+    int elevatorReversals;
+    ElevatorPolicy elevatorPolicy;
+
+    // Skip the per-chunk output.
+    bool quiet;
+
+    // Requests fed one at a time wait here until a chunk is full.
+    int chunk[D_CHUNK_SIZE];
+    int chunkLength;
+    long seekCount;
+    double seekSum;
+    double seekSumOfSquares;
+
+    // The sums above already cover the whole trace (e.g. from a cache).
+    bool statsKnown;
+
+    // Every request so far by cylinder: built by simulationFeed for
+    // streams, or borrowed from the table the trace was read into.
+    SeekHistogram *histogram;
+
+    // Chunks processed, and where per-chunk distance buckets are logged
+    long chunks;
+    const char *distanceLogPath;
+    FILE *distanceLog;
+
+    // Check that every schedule is a reordering of its chunk.
+    bool checkSchedules;
+    long schedulesChecked;
+    long scheduleViolations[SCHEDULERS_MAX];
+
+    // This run's state for each plugin scheduler, made on first use
+    void *pluginStates[SCHEDULERS_MAX];
+
+    // When set, chunk results go here to be printed elsewhere.
+    void (*emit)(void *context, const ChunkResult *result);
+    void *emitContext;
+    Writer *writer;
+};
+
+extern Scheduler schedulers[SCHEDULERS_MAX];
+extern int schedulerCount;
+
+bool streq(const char *a, const char *b);
+int min(const int a, const int b);
+int randint(const int min, const int max);
+
+double monotonicSeconds(void);
+
+long envLong(const char *name, const long fallback);
+double envDouble(const char *name, const double fallback);
+
+void *_safe_malloc(const size_t size, const char *file, const int line);
+void *_safe_realloc(void *ptr, const size_t size, const char *file,
+                    const int line);
+
+static inline int distanceBucket(const int distance)
+{
+    int bucket = 31 - __builtin_clz(distance);
+    return bucket < DISTANCE_BUCKETS ? bucket : DISTANCE_BUCKETS - 1;
+}
+
+void printHeader(const char text[]);
+void printIntList(const int list[], const int length);
+void printStreamConclusion(const Simulation *sim);
+void printRunningTotals(const Simulation *sim);
+
+void simulationInit(Simulation *sim);
+void configure(Simulation *sim);
+
+void process(Simulation *sim, SeekList seeks);
+void processInChunks(Simulation *sim, SeekList seeks);
+void processChunk(Simulation *sim, SeekList seeks);
+void simulationFeed(Simulation *sim, const int seek);
+void simulationCount(Simulation *sim, const int seek);
+void simulationQueue(Simulation *sim, const int seek);
+void simulationFinish(Simulation *sim);
+void simulationFree(Simulation *sim);
+
+void firstComeFirstServed(Simulation *sim, SchedulerState *state,
+                          SeekList *seeks);
+void shortestSeekFirst(Simulation *sim, SchedulerState *state,
+                       SeekList *seeks);
+void elevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                       SeekList *seeks);
+bool elevatorInitialDirection(const Simulation *sim, SeekList seeks,
+                              const int start);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Scheduler plugin interface
+ *
+ * Everything a plugin needs to build against, and nothing from the
+ * simulator's own structures, so a plugin keeps loading across simulator
+ * changes until DASS_PLUGIN_ABI is bumped. A plugin is a shared object
+ * exporting a function named DASS_PLUGIN_SYMBOL that returns its table of
+ * schedulers:
+ *
+ *     static void reverse(void *context, int head, int seeks[], int length)
+ *     {
+ *         ...
+ *     }
+ *
+ *     static const DassScheduler table[] = {
+ *         {"Reverse arrival", "reverse", reverse, NULL},
+ *     };
+ *
+ *     const DassPlugin *dassPlugin(void)
+ *     {
+ *         static const DassPlugin plugin = {DASS_PLUGIN_ABI, 1, table};
+ *         return &plugin;
+ *     }
+ *
+ * Build with `cc -shared -fPIC -o reverse.so reverse.c` and run with
+ * `dass --plugin ./reverse.so <command>`.
+ *
+ * Runs happen concurrently (batch workers, oracle connections), so a
+ * scheduler that keeps anything between chunks supplies `create` and
+ * `destroy`: each run then gets its own state from `create`, and that is
+ * what `schedule` receives. Without them, `schedule` receives `context`
+ * itself, shared by every run, and must not change it.
+ *
+ * @file dassplugin.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef DASSPLUGIN_H
+#define DASSPLUGIN_H
+
+#define DASS_PLUGIN_ABI 2
+#define DASS_PLUGIN_SYMBOL "dassPlugin"
+
+typedef struct DassScheduler
+{
+    // Shown in output headings
+    const char *title;
+    // Short name used in reports and by the oracle; must be unique
+    const char *key;
+
+    // Reorder seeks[0..length) in place into the order they would be
+    // served in with the head at `head`. Cylinders are 0 to 65535. The
+    // simulator works out distance, tally and the next head from the
+    // order, so anything carried between chunks lives in `state`.
+    void (*schedule)(void *state, int head, int seeks[], int length);
+    // Read-only, shared by every run
+    void *context;
+
+    // Optional: make one run's state on its first chunk, and free it
+    // when the run is over.
+    void *(*create)(void *context);
+    void (*destroy)(void *state);
+} DassScheduler;
+
+typedef struct DassPlugin
+{
+    unsigned abi;
+    int count;
+    const DassScheduler *schedulers;
+} DassPlugin;
+
+typedef const DassPlugin *(*DassPluginEntry)(void);
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * Seek distance distributions
+ *
+ * @file distance.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dass.h"
+#include "distance.h"
+
+static bool openLog(Simulation *sim);
+static void writeBuckets(FILE *out, const long buckets[],
+                         const long subtract[]);
+static void formatBucket(char label[], const size_t size, const int bucket);
+
+void distanceLogChunk(Simulation *sim, const int scheduler,
+                      const SchedulerState *before, const int requests)
+{
+    if (sim->distanceLog == NULL && !openLog(sim))
+        return;
+
+    const SchedulerState *after = &sim->states[scheduler];
+
+    fprintf(sim->distanceLog,
+            "{\"chunk\": %ld, \"scheduler\": \"%s\", \"requests\": %d, "
+            "\"seeks\": %d, \"distance\": %ld, \"buckets\": ",
+            sim->chunks, schedulers[scheduler].key, requests,
+            after->tally - before->tally, after->distance - before->distance);
+    writeBuckets(sim->distanceLog, after->buckets, before->buckets);
+    fprintf(sim->distanceLog, "}\n");
+}
+
+void distanceLogClose(Simulation *sim)
+{
+    if (sim->distanceLog == NULL)
+        return;
+
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        const SchedulerState *state = &sim->states[i];
+
+        fprintf(sim->distanceLog,
+                "{\"total\": true, \"scheduler\": \"%s\", \"chunks\": %ld, "
+                "\"seeks\": %d, \"distance\": %ld, \"buckets\": ",
+                schedulers[i].key, sim->chunks, state->tally,
+                state->distance);
+        writeBuckets(sim->distanceLog, state->buckets, NULL);
+        fprintf(sim->distanceLog, "}\n");
+    }
+
+    if (fclose(sim->distanceLog) != 0)
+        fprintf(stderr, "Could not write distance log: %s\n",
+                sim->distanceLogPath);
+
+    sim->distanceLog = NULL;
+}
+
+void printDistanceBuckets(const Simulation *sim)
+{
+    // Every bucket, empty or not, so tables from different runs line up
+    printHeader("Seek distance distribution");
+    printf("%-12s", "Distance");
+    for (int i = 0; i < schedulerCount; i++)
+        printf(" %10s", schedulers[i].key);
+    printf("\n");
+
+    for (int b = 0; b < DISTANCE_BUCKETS; b++)
+    {
+        char label[32];
+        formatBucket(label, sizeof(label), b);
+
+        printf("%-12s", label);
+        for (int i = 0; i < schedulerCount; i++)
+            printf(" %10ld", sim->states[i].buckets[b]);
+        printf("\n");
+    }
+}
+
+static bool openLog(Simulation *sim)
+{
+    sim->distanceLog = fopen(sim->distanceLogPath, "w");
+
+    if (sim->distanceLog == NULL)
+    {
+        fprintf(stderr, "Could not open distance log: %s\n",
+                sim->distanceLogPath);
+
+        // Don't try again for every chunk.
+        sim->distanceLogPath = NULL;
+        return false;
+    }
+
+    // Say what the buckets mean once, up front.
+    fprintf(sim->distanceLog, "{\"bucket_lower_bounds\": [");
+    for (int b = 0; b < DISTANCE_BUCKETS; b++)
+        fprintf(sim->distanceLog, "%s%d", b > 0 ? ", " : "", 1 << b);
+    fprintf(sim->distanceLog, "]}\n");
+
+    return true;
+}
+
+static void writeBuckets(FILE *out, const long buckets[],
+                         const long subtract[])
+{
+    fputc('[', out);
+
+    for (int b = 0; b < DISTANCE_BUCKETS; b++)
+    {
+        fprintf(out, "%s%ld", b > 0 ? ", " : "",
+                buckets[b] - (subtract != NULL ? subtract[b] : 0));
+    }
+
+    fputc(']', out);
+}
+
+static void formatBucket(char label[], const size_t size, const int bucket)
+{
+    int low = 1 << bucket;
+    int high = (1 << (bucket + 1)) - 1;
+
+    if (bucket == DISTANCE_BUCKETS - 1)
+        snprintf(label, size, "%d+", low);
+    else if (low == high)
+        snprintf(label, size, "%d", low);
+    else
+        snprintf(label, size, "%d-%d", low, high);
+}
@@ -0,0 +1,26 @@
+/**
+ * Seek distance distributions
+ *
+ * Total distance can't tell many short seeks from a few long ones, which
+ * is what decides time on a real drive. Each scheduler counts its seeks
+ * into power-of-two distance buckets as it adds them up; the conclusion
+ * tabulates the totals in every bucket, and D_DISTANCE_LOG names a file
+ * that gets the buckets for every chunk and scheduler as JSON lines,
+ * followed by a line of totals for each scheduler.
+ *
+ * @file distance.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include "dass.h"
+
+void distanceLogChunk(Simulation *sim, const int scheduler,
+                      const SchedulerState *before, const int requests);
+void distanceLogClose(Simulation *sim);
+void printDistanceBuckets(const Simulation *sim);
+
+#endif
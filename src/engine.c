@@ -0,0 +1,198 @@
+/**
+ * Discrete-event engine for timed simulations
+ *
+ * @file engine.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <string.h>
+
+#include "dass.h"
+#include "engine.h"
+
+#define ARITY 4
+#define CACHE_LINE 64
+
+// Slots skipped at the front of the time column so that every group of
+// four siblings starts on a 32-byte boundary.
+#define TIME_OFFSET (ARITY - 1)
+
+static void eventQueueReserve(EventQueue *queue, const int capacity);
+static inline bool eventBefore(const double timeA, const int indexA,
+                               const int kindA, const double timeB,
+                               const int indexB, const int kindB);
+static inline void eventMove(EventQueue *queue, const int to,
+                             const int from);
+
+void eventQueueInit(EventQueue *queue, const int capacity)
+{
+    queue->pool = NULL;
+    queue->length = 0;
+    queue->capacity = 0;
+
+    eventQueueReserve(queue, capacity > 0 ? capacity : D_DYNAMIC_BASE_SIZE);
+}
+
+void eventQueueFree(EventQueue *queue)
+{
+    free(queue->pool);
+    queue->pool = NULL;
+    queue->length = 0;
+    queue->capacity = 0;
+}
+
+void eventQueueClear(EventQueue *queue)
+{
+    // The pool is kept for the next run.
+    queue->length = 0;
+}
+
+void eventQueuePush(EventQueue *queue, const double time, const int index,
+                    const int kind)
+{
+    if (queue->length == queue->capacity)
+        eventQueueReserve(queue, queue->capacity * 2);
+
+    int position = queue->length++;
+
+    // Sift up.
+    while (position > 0)
+    {
+        int parent = (position - 1) / ARITY;
+
+        if (!eventBefore(time, index, kind, queue->time[parent],
+                         queue->index[parent], queue->kind[parent]))
+            break;
+
+        eventMove(queue, position, parent);
+        position = parent;
+    }
+
+    queue->time[position] = time;
+    queue->index[position] = index;
+    queue->kind[position] = kind;
+}
+
+bool eventQueuePop(EventQueue *queue, Event *event)
+{
+    if (queue->length == 0)
+        return false;
+
+    *event = (Event){queue->time[0], queue->index[0], queue->kind[0]};
+
+    int last = --queue->length;
+
+    if (last == 0)
+        return true;
+
+    const double *times = queue->time;
+    double time = times[last];
+    int index = queue->index[last];
+    int kind = queue->kind[last];
+
+    // The displaced last event nearly always belongs near the bottom, so
+    // walk the hole down along the earliest children without comparing
+    // against it, then sift it back up from there.
+    int position = 0;
+
+    for (;;)
+    {
+        int child = position * ARITY + 1;
+
+        if (child >= last)
+            break;
+
+        int end = child + ARITY < last ? child + ARITY : last;
+        int best = child;
+
+        for (int sibling = child + 1; sibling < end; sibling++)
+        {
+            if (times[sibling] < times[best] ||
+                (times[sibling] == times[best] &&
+                 eventBefore(times[sibling], queue->index[sibling],
+                             queue->kind[sibling], times[best],
+                             queue->index[best], queue->kind[best])))
+                best = sibling;
+        }
+
+        eventMove(queue, position, best);
+        position = best;
+    }
+
+    while (position > 0)
+    {
+        int parent = (position - 1) / ARITY;
+
+        if (!eventBefore(time, index, kind, times[parent],
+                         queue->index[parent], queue->kind[parent]))
+            break;
+
+        eventMove(queue, position, parent);
+        position = parent;
+    }
+
+    queue->time[position] = time;
+    queue->index[position] = index;
+    queue->kind[position] = kind;
+
+    return true;
+}
+
+static void eventQueueReserve(EventQueue *queue, const int capacity)
+{
+    // Each column starts on its own cache line.
+    size_t slots = capacity;
+    size_t timeBytes = (slots + TIME_OFFSET) * sizeof(double);
+    size_t indexBytes = slots * sizeof(int);
+    timeBytes = (timeBytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    indexBytes = (indexBytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    size_t kindBytes = (slots + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+    void *pool = aligned_alloc(CACHE_LINE, timeBytes + indexBytes + kindBytes);
+    if (pool == NULL)
+    {
+        fprintf(stderr, "Allocation error @ %s:%d (%zu bytes)\n", __FILE__,
+                __LINE__, timeBytes + indexBytes + kindBytes);
+        exit(EXIT_FAILURE);
+    }
+
+    double *time = (double *)pool + TIME_OFFSET;
+    int *index = (int *)((char *)pool + timeBytes);
+    unsigned char *kind = (unsigned char *)pool + timeBytes + indexBytes;
+
+    if (queue->pool != NULL)
+    {
+        memcpy(time, queue->time, sizeof(double) * queue->length);
+        memcpy(index, queue->index, sizeof(int) * queue->length);
+        memcpy(kind, queue->kind, queue->length);
+        free(queue->pool);
+    }
+
+    queue->pool = pool;
+    queue->time = time;
+    queue->index = index;
+    queue->kind = kind;
+    queue->capacity = capacity;
+}
+
+static inline bool eventBefore(const double timeA, const int indexA,
+                               const int kindA, const double timeB,
+                               const int indexB, const int kindB)
+{
+    // Simultaneous events fall back on their index so runs are repeatable.
+    if (timeA != timeB)
+        return timeA < timeB;
+
+    if (indexA != indexB)
+        return indexA < indexB;
+
+    return kindA < kindB;
+}
+
+static inline void eventMove(EventQueue *queue, const int to, const int from)
+{
+    queue->time[to] = queue->time[from];
+    queue->index[to] = queue->index[from];
+    queue->kind[to] = queue->kind[from];
+}
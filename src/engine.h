@@ -0,0 +1,43 @@
+/**
+ * Discrete-event engine for timed simulations
+ *
+ * @file engine.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+
+typedef struct Event
+{
+    double time;
+    int index;
+    int kind;
+} Event;
+
+// A 4-ary implicit heap kept as parallel columns in one pooled block, so
+// sifting compares a run of adjacent times instead of chasing structs.
+typedef struct EventQueue
+{
+    void *pool;
+    double *time;
+    int *index;
+    unsigned char *kind;
+    int length;
+    int capacity;
+} EventQueue;
+
+// Bytes held per queued event across all columns
+#define EVENT_SLOT_BYTES (sizeof(double) + sizeof(int) + sizeof(unsigned char))
+
+void eventQueueInit(EventQueue *queue, const int capacity);
+void eventQueueFree(EventQueue *queue);
+void eventQueueClear(EventQueue *queue);
+void eventQueuePush(EventQueue *queue, const double time, const int index,
+                    const int kind);
+bool eventQueuePop(EventQueue *queue, Event *event);
+
+#endif
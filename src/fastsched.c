@@ -0,0 +1,372 @@
+/**
+ * Faster scheduler engines
+ *
+ * @file fastsched.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dass.h"
+#include "fastsched.h"
+
+// Per-thread working space, kept from chunk to chunk, since batch workers
+// and the pipeline schedule concurrently
+typedef struct Scratch
+{
+    int *space;
+    size_t capacity;
+} Scratch;
+
+static pthread_key_t scratchKey;
+static pthread_once_t scratchOnce = PTHREAD_ONCE_INIT;
+
+static int *scratch(const size_t count);
+static void createKey(void);
+static void freeScratch(void *pointer);
+static void chooseShortestSeekFirst(Simulation *sim, SchedulerState *state,
+                                    SeekList *seeks);
+static void chooseElevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                                    SeekList *seeks);
+static int compareInts(const void *a, const void *b);
+static int lowerBound(const int sorted[], const int length, const int value);
+static void siftDown(int heap[], const int size);
+
+void fastShortestSeekFirst(Simulation *sim, SchedulerState *state,
+                           SeekList *seeks)
+{
+    (void)sim;
+
+    const int length = seeks->length;
+    int *list = seeks->list;
+
+    if (length == 0)
+        return;
+
+    // Distinct positions in ascending order, linked so that served ones
+    // drop out and the nearest on either side is always a step away.
+    int *space = scratch(8 * (size_t)length + 1);
+    int *values = space;
+    memcpy(values, list, sizeof(int) * length);
+    qsort(values, length, sizeof(int), compareInts);
+
+    int distinct = 0;
+    for (int i = 0; i < length; i++)
+    {
+        if (distinct == 0 || values[distinct - 1] != values[i])
+            values[distinct++] = values[i];
+    }
+
+    int *counts = space + length;
+    int *previous = counts + distinct;
+    int *next = previous + distinct;
+    int *nodes = next + distinct;
+
+    memset(counts, 0, sizeof(int) * distinct);
+    for (int i = 0; i < length; i++)
+    {
+        nodes[i] = lowerBound(values, distinct, list[i]);
+        counts[nodes[i]]++;
+    }
+
+    // The original swaps each pick to the front and breaks ties by the
+    // lowest index, so where every copy sits has to be followed too:
+    // each position keeps a min-heap of the indices holding it.
+    int *heapStart = nodes + length;
+    int *heapSize = heapStart + distinct + 1;
+    int *heaps = heapSize + distinct;
+
+    heapStart[0] = 0;
+    memset(heapSize, 0, sizeof(int) * distinct);
+    for (int k = 0; k < distinct; k++)
+    {
+        heapStart[k + 1] = heapStart[k] + counts[k];
+        previous[k] = k - 1;
+        next[k] = k + 1;
+    }
+
+    // Added in ascending order, so each heap starts out already valid.
+    for (int i = 0; i < length; i++)
+    {
+        int k = nodes[i];
+        heaps[heapStart[k] + heapSize[k]++] = i;
+    }
+
+    int seekPosition = state->start;
+    int above = lowerBound(values, distinct, seekPosition);
+    int below = above - 1;
+    int here = -1;
+
+    if (above < distinct && values[above] == seekPosition)
+    {
+        here = above;
+        above++;
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        int pick = here;
+
+        if (pick == -1)
+        {
+            if (below < 0)
+            {
+                pick = above;
+            }
+            else if (above >= distinct)
+            {
+                pick = below;
+            }
+            else
+            {
+                int down = seekPosition - values[below];
+                int up = values[above] - seekPosition;
+
+                if (down != up)
+                    pick = down < up ? below : above;
+                else
+                    pick = heaps[heapStart[below]] < heaps[heapStart[above]]
+                               ? below
+                               : above;
+            }
+
+            here = pick;
+            below = previous[pick];
+            above = next[pick];
+        }
+
+        // Take the pick's first copy and swap it to the front.
+        int *heap = heaps + heapStart[pick];
+        int index = heap[0];
+
+        heap[0] = heap[--heapSize[pick]];
+        siftDown(heap, heapSize[pick]);
+
+        if (index != i)
+        {
+            // The front holds the lowest index left, so it tops its heap.
+            int front = nodes[i];
+            int *frontHeap = heaps + heapStart[front];
+
+            frontHeap[0] = index;
+            siftDown(frontHeap, heapSize[front]);
+
+            int value = list[i];
+            list[i] = list[index];
+            list[index] = value;
+
+            nodes[index] = front;
+            nodes[i] = pick;
+        }
+
+        if (seekPosition != values[pick])
+        {
+            int distance = abs(values[pick] - seekPosition);
+
+            state->distance += distance;
+            state->buckets[distanceBucket(distance)]++;
+            seekPosition = values[pick];
+            state->tally++;
+        }
+
+        if (--counts[pick] == 0)
+        {
+            if (below >= 0)
+                next[below] = above;
+            if (above < distinct)
+                previous[above] = below;
+
+            here = -1;
+        }
+    }
+
+    state->start = seekPosition;
+}
+
+void fastElevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                           SeekList *seeks)
+{
+    const int length = seeks->length;
+    int *list = seeks->list;
+
+    if (length == 0)
+        return;
+
+    if (!sim->elevatorStarted)
+    {
+        sim->elevatorUp = elevatorInitialDirection(sim, *seeks, state->start);
+        sim->elevatorStarted = true;
+    }
+
+    const bool up = sim->elevatorUp;
+    const int start = state->start;
+
+    // Whatever lies ahead (or level) in sweep order, then the rest on the
+    // way back.
+    int *sorted = scratch(length);
+    memcpy(sorted, list, sizeof(int) * length);
+    qsort(sorted, length, sizeof(int), compareInts);
+
+    int split = lowerBound(sorted, length, up ? start : start + 1);
+    int ahead = up ? length - split : split;
+
+    for (int i = 0; i < length; i++)
+    {
+        if (up)
+            list[i] = i < ahead ? sorted[split + i] : sorted[length - 1 - i];
+        else
+            list[i] = i < ahead ? sorted[split - 1 - i] : sorted[i];
+    }
+
+    int seekPosition = start;
+
+    for (int i = 0; i < length; i++)
+    {
+        bool sweep = i < ahead ? up : !up;
+        bool moved = state->distance > 0 || seekPosition != start;
+
+        if (sim->elevatorUp != sweep && list[i] != seekPosition)
+        {
+            if (moved)
+                sim->elevatorReversals++;
+
+            sim->elevatorUp = sweep;
+        }
+
+        seekPosition = list[i];
+    }
+
+    seekPosition = start;
+
+    for (int i = 0; i < length; i++)
+    {
+        if (list[i] != seekPosition)
+        {
+            int distance = abs(list[i] - seekPosition);
+
+            state->tally++;
+            state->distance += distance;
+            state->buckets[distanceBucket(distance)]++;
+        }
+        seekPosition = list[i];
+    }
+
+    state->start = seekPosition;
+}
+
+void useFastSchedulers(void)
+{
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        if (schedulers[i].schedule == shortestSeekFirst)
+            schedulers[i].schedule = chooseShortestSeekFirst;
+        else if (schedulers[i].schedule == elevatorAlgorithm)
+            schedulers[i].schedule = chooseElevatorAlgorithm;
+    }
+}
+
+static int *scratch(const size_t count)
+{
+    pthread_once(&scratchOnce, createKey);
+
+    Scratch *s = pthread_getspecific(scratchKey);
+
+    if (s == NULL)
+    {
+        s = safe_malloc(sizeof(Scratch));
+        *s = (Scratch){0};
+        pthread_setspecific(scratchKey, s);
+    }
+
+    if (count > s->capacity)
+    {
+        s->space = safe_realloc(s->space, sizeof(int) * count);
+        s->capacity = count;
+    }
+
+    return s->space;
+}
+
+static void createKey(void)
+{
+    pthread_key_create(&scratchKey, freeScratch);
+}
+
+static void freeScratch(void *pointer)
+{
+    Scratch *s = pointer;
+
+    free(s->space);
+    free(s);
+}
+
+static void chooseShortestSeekFirst(Simulation *sim, SchedulerState *state,
+                                    SeekList *seeks)
+{
+    if (seeks->length < FAST_SSTF_MIN_LENGTH)
+        shortestSeekFirst(sim, state, seeks);
+    else
+        fastShortestSeekFirst(sim, state, seeks);
+}
+
+static void chooseElevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                                    SeekList *seeks)
+{
+    if (seeks->length < FAST_ELEVATOR_MIN_LENGTH)
+        elevatorAlgorithm(sim, state, seeks);
+    else
+        fastElevatorAlgorithm(sim, state, seeks);
+}
+
+static int compareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int lowerBound(const int sorted[], const int length, const int value)
+{
+    int low = 0;
+    int high = length;
+
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+
+        if (sorted[middle] < value)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static void siftDown(int heap[], const int size)
+{
+    int i = 0;
+
+    for (;;)
+    {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+
+        if (left < size && heap[left] < heap[smallest])
+            smallest = left;
+        if (right < size && heap[right] < heap[smallest])
+            smallest = right;
+
+        if (smallest == i)
+            return;
+
+        int value = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = value;
+        i = smallest;
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * Faster scheduler engines
+ *
+ * Drop-in replacements for the O(n²) shortest seek first and elevator
+ * schedulers in main.c, for chunks big enough that the scans matter. They
+ * give exactly the same orders, tallies, distances and elevator state as
+ * the originals, ties and duplicates included; `dass verify` checks that.
+ *
+ * They're opt-in (D_FAST_SCHEDULERS=1), and even then only take chunks
+ * long enough to gain from them: below that, sorting costs more than the
+ * scans it saves (at the default chunk size of 20, a good deal more), so
+ * the originals run instead.
+ *
+ * Both thresholds are above D_CHUNK_SIZE, so every chunked run (file,
+ * pipe, batch, follow, shm, merge, replay) keeps the originals whatever
+ * D_FAST_SCHEDULERS says. The setting only reaches oracle batches,
+ * `dass bench` and builds with CHUNK turned off; `dass verify` runs the
+ * engines directly either way.
+ *
+ * @file fastsched.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef FASTSCHED_H
+#define FASTSCHED_H
+
+#include "dass.h"
+
+// Where each fast engine overtakes its original in `dass verify`
+#define FAST_SSTF_MIN_LENGTH 160
+#define FAST_ELEVATOR_MIN_LENGTH 32
+
+void fastShortestSeekFirst(Simulation *sim, SchedulerState *state,
+                           SeekList *seeks);
+void fastElevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                           SeekList *seeks);
+
+void useFastSchedulers(void);
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * Following a trace as it grows
+ *
+ * @file follow.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "parse.h"
+#include "follow.h"
+
+#define EVENT_BUFFER_SIZE 4096
+
+typedef struct Follower
+{
+    int fd;
+    off_t offset;
+
+    // Bytes read but not yet parsed: a token still being written
+    char *text;
+    size_t length;
+    size_t capacity;
+
+    int *seeks;
+    Validation validation;
+    Simulation sim;
+} Follower;
+
+static volatile sig_atomic_t interrupted;
+
+static void interrupt(int signal);
+static bool catchUp(Follower *follower);
+
+bool followTrace(const char *path)
+{
+    Follower follower = {
+        .fd = open(path, O_RDONLY),
+        .capacity = FOLLOW_READ_SIZE,
+    };
+
+    if (follower.fd < 0)
+    {
+        fprintf(stderr, "Could not open file: %s\n", path);
+        return false;
+    }
+
+    int watch = inotify_init1(IN_CLOEXEC);
+
+    if (watch < 0 ||
+        inotify_add_watch(watch, path,
+                          IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF |
+                              IN_MOVE_SELF) < 0)
+    {
+        fprintf(stderr, "Could not watch file: %s\n", path);
+        close(follower.fd);
+        if (watch >= 0)
+            close(watch);
+        return false;
+    }
+
+    follower.text = safe_malloc(follower.capacity);
+    follower.seeks = safe_malloc(sizeof(int) * (follower.capacity / 2 + 1));
+    validationInit(&follower.validation);
+    simulationInit(&follower.sim);
+
+    // Stop cleanly on an interrupt so the conclusion still gets printed.
+    struct sigaction action = {.sa_handler = interrupt};
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    const double interval = envDouble("D_FOLLOW_INTERVAL", FOLLOW_INTERVAL);
+    double nextTotals = monotonicSeconds() + interval;
+    long reported = 0;
+    bool following = catchUp(&follower);
+
+    while (following && !interrupted)
+    {
+        double now = monotonicSeconds();
+
+        if (now >= nextTotals)
+        {
+            if (follower.sim.seekCount != reported)
+            {
+                printRunningTotals(&follower.sim);
+                fflush(stdout);
+                reported = follower.sim.seekCount;
+            }
+
+            nextTotals = now + interval;
+        }
+
+        struct pollfd event = {.fd = watch, .events = POLLIN};
+        int timeout = (nextTotals - now) * 1000 + 1;
+
+        if (poll(&event, 1, timeout) <= 0)
+            continue;
+
+        char events[EVENT_BUFFER_SIZE]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t got = read(watch, events, sizeof(events));
+
+        for (char *p = events; got > 0 && p < events + got;)
+        {
+            const struct inotify_event *change = (void *)p;
+
+            if (change->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                following = false;
+
+            // Our descriptor keeps a removed trace alive, so removal shows
+            // up as its last link going away.
+            struct stat info;
+            if ((change->mask & IN_ATTRIB) &&
+                fstat(follower.fd, &info) == 0 && info.st_nlink == 0)
+            {
+                following = false;
+            }
+
+            p += sizeof(struct inotify_event) + change->len;
+        }
+
+        // Whatever was written before a removal still counts.
+        if (!catchUp(&follower))
+            following = false;
+    }
+
+    if (!follower.validation.failed)
+    {
+        // Nothing more is coming, so a trailing seek without its newline
+        // is complete after all.
+        int count = parseSeekText(follower.text,
+                                  follower.text + follower.length,
+                                  follower.seeks, &follower.validation);
+
+        for (int i = 0; i < count; i++)
+            simulationFeed(&follower.sim, follower.seeks[i]);
+    }
+
+    // A strict-mode failure still flushes what was already printed and
+    // frees the simulation, but gets no conclusion.
+    follower.sim.quiet = follower.validation.failed;
+    simulationFinish(&follower.sim);
+
+    bool ok = validationReport(&follower.validation, path);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    close(watch);
+    close(follower.fd);
+    free(follower.text);
+    free(follower.seeks);
+
+    return ok;
+}
+
+static void interrupt(int signal)
+{
+    (void)signal;
+    interrupted = 1;
+}
+
+static bool catchUp(Follower *follower)
+{
+    struct stat info;
+
+    // A truncated trace is being rewritten; start over from its top.
+    if (fstat(follower->fd, &info) == 0 && info.st_size < follower->offset)
+    {
+        fprintf(stderr, "Trace truncated; reading from the start.\n");
+        follower->offset = 0;
+        follower->length = 0;
+    }
+
+    for (;;)
+    {
+        if (follower->length == follower->capacity)
+        {
+            // One token bigger than the whole buffer
+            follower->capacity *= 2;
+            follower->text = safe_realloc(follower->text, follower->capacity);
+            follower->seeks = safe_realloc(
+                follower->seeks, sizeof(int) * (follower->capacity / 2 + 1));
+        }
+
+        ssize_t got = pread(follower->fd, follower->text + follower->length,
+                            follower->capacity - follower->length,
+                            follower->offset);
+
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+
+        follower->offset += got;
+        follower->length += got;
+
+        const char *end =
+            wholeTokens(follower->text, follower->text + follower->length);
+        int count = parseSeekText(follower->text, end, follower->seeks,
+                                  &follower->validation);
+
+        for (int i = 0; i < count; i++)
+            simulationFeed(&follower->sim, follower->seeks[i]);
+
+        follower->length -= end - follower->text;
+        memmove(follower->text, end, follower->length);
+
+        if (follower->validation.failed)
+            return false;
+    }
+
+    fflush(stdout);
+
+    return true;
+}
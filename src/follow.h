@@ -0,0 +1,27 @@
+/**
+ * Following a trace as it grows
+ *
+ * The trace is read to its current end, then watched with inotify. Each
+ * time it grows, the new seeks go through the usual chunking as soon as
+ * they are complete, and every D_FOLLOW_INTERVAL seconds (when anything
+ * has changed) the running totals are printed. Following stops when the
+ * trace is removed or renamed, or on an interrupt; the conclusion follows.
+ *
+ * @file follow.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+#include "dass.h"
+
+// Seconds between running totals
+#define FOLLOW_INTERVAL 5
+
+#define FOLLOW_READ_SIZE 65536
+
+bool followTrace(const char *path);
+
+#endif
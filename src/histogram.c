@@ -0,0 +1,100 @@
+/**
+ * Cylinder histogram
+ *
+ * @file histogram.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dass.h"
+#include "histogram.h"
+
+SeekHistogram *histogramCreate(void)
+{
+    SeekHistogram *histogram = safe_malloc(sizeof(SeekHistogram));
+    memset(histogram, 0, sizeof(SeekHistogram));
+    return histogram;
+}
+
+void histogramAddMany(SeekHistogram *histogram, const int seeks[],
+                      const long count)
+{
+    uint32_t *bins = histogram->bins - D_SIZE_MIN;
+    long i = 0;
+
+    // Increments can't be vectorised, but unrolling keeps several in
+    // flight when they hit different bins.
+    for (; i + 4 <= count; i += 4)
+    {
+        bins[seeks[i]]++;
+        bins[seeks[i + 1]]++;
+        bins[seeks[i + 2]]++;
+        bins[seeks[i + 3]]++;
+    }
+
+    for (; i < count; i++)
+        bins[seeks[i]]++;
+
+    histogram->count += count;
+}
+
+void histogramMerge(SeekHistogram *into, const SeekHistogram *from)
+{
+    // Written as a plain loop over both arrays so it vectorises.
+    for (int i = 0; i < HISTOGRAM_BINS; i++)
+        into->bins[i] += from->bins[i];
+
+    into->count += from->count;
+}
+
+int histogramPercentile(const SeekHistogram *histogram, const int percent)
+{
+    // Nearest rank, so the answer is always a cylinder actually requested
+    long rank = (histogram->count * percent + 99) / 100;
+    if (rank < 1)
+        rank = 1;
+
+    long seen = 0;
+
+    for (int i = 0; i < HISTOGRAM_BINS; i++)
+    {
+        seen += histogram->bins[i];
+
+        if (seen >= rank)
+            return D_SIZE_MIN + i;
+    }
+
+    return D_SIZE_MAX;
+}
+
+void printDistribution(const SeekHistogram *histogram)
+{
+    if (histogram == NULL || histogram->count == 0)
+        return;
+
+    int mode = 0;
+
+    for (int i = 1; i < HISTOGRAM_BINS; i++)
+    {
+        if (histogram->bins[i] > histogram->bins[mode])
+            mode = i;
+    }
+
+    printf(
+        "Minimum: %d\n"
+        "25th percentile: %d\n"
+        "Median: %d\n"
+        "75th percentile: %d\n"
+        "90th percentile: %d\n"
+        "99th percentile: %d\n"
+        "Maximum: %d\n"
+        "Mode: %d (%u request%s)\n",
+        histogramPercentile(histogram, 0), histogramPercentile(histogram, 25),
+        histogramPercentile(histogram, 50), histogramPercentile(histogram, 75),
+        histogramPercentile(histogram, 90), histogramPercentile(histogram, 99),
+        histogramPercentile(histogram, 100), D_SIZE_MIN + mode,
+        histogram->bins[mode], histogram->bins[mode] == 1 ? "" : "s");
+}
@@ -0,0 +1,44 @@
+/**
+ * Cylinder histogram
+ *
+ * Requests can only land on one of 65536 cylinders, so a bin per cylinder
+ * gives exact order statistics (minimum, maximum, median, percentiles and
+ * mode) in constant space. The bins are counted as requests are read, so
+ * reporting them never takes another pass over the trace.
+ *
+ * @file histogram.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+#include "dass.h"
+
+#define HISTOGRAM_BINS (D_SIZE_MAX - D_SIZE_MIN + 1)
+
+// 32-bit bins keep the table at 256 KiB; one cylinder would need four
+// billion requests to overflow.
+struct SeekHistogram
+{
+    uint32_t bins[HISTOGRAM_BINS];
+    long count;
+};
+
+SeekHistogram *histogramCreate(void);
+void histogramAddMany(SeekHistogram *histogram, const int seeks[],
+                      const long count);
+void histogramMerge(SeekHistogram *into, const SeekHistogram *from);
+int histogramPercentile(const SeekHistogram *histogram, const int percent);
+void printDistribution(const SeekHistogram *histogram);
+
+static inline void histogramAdd(SeekHistogram *histogram, const int seek)
+{
+    histogram->bins[seek - D_SIZE_MIN]++;
+    histogram->count++;
+}
+
+#endif
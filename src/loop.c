@@ -0,0 +1,559 @@
+/**
+ * Closed-loop workload simulation
+ *
+ * Each client issues one request, waits for it to complete, thinks for a
+ * while and then issues the next, so the depth of the disk queue falls out
+ * of the concurrency rather than being dictated by a trace.
+ *
+ * The disk picks requests itself, off the per-cylinder queue below, rather
+ * than through schedulers[]. Only the built-in FCFS, SSTF and elevator are
+ * supported: plugins, the fast engines and D_ELEVATOR_DIR have no effect
+ * here, and the elevator always sets off upward.
+ *
+ * @file loop.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+#include "dass.h"
+#include "engine.h"
+#include "loop.h"
+#include "coroutine.h"
+
+#define LOOP_REQUESTS 10000
+#define LOOP_THINK_TIME 10.0
+
+#define CYLINDERS (D_SIZE_MAX - D_SIZE_MIN + 1)
+#define WORDS ((CYLINDERS + 63) / 64)
+#define SUMMARY_WORDS ((WORDS + 63) / 64)
+#define NONE -1
+
+enum
+{
+    EVENT_RESUME,
+    EVENT_COMPLETION
+};
+
+// Everything a client needs between resumptions
+typedef struct Client
+{
+    double issued;
+    unsigned int random;
+    int next;
+    unsigned short line;
+    unsigned short cylinder;
+} Client;
+
+// Pending requests, queued per cylinder so the schedulers can find the
+// nearest one without scanning the whole queue
+typedef struct PendingSet
+{
+    int *first;
+    int *last;
+    unsigned long long words[WORDS];
+    unsigned long long summary[SUMMARY_WORDS];
+    int fifoFirst;
+    int fifoLast;
+    int length;
+} PendingSet;
+
+typedef struct LoopSim
+{
+    const LoopConfig *config;
+    LoopPolicy policy;
+    Client *clients;
+    PendingSet pending;
+    EventQueue *events;
+
+    double now;
+    bool busy;
+    bool up;
+    int head;
+
+    long completed;
+    long handled;
+    long distance;
+    double responseSum;
+} LoopSim;
+
+static const char *policyKeys[] = {"fcfs", "sstf", "elevator"};
+static const char *distributionNames[] = {"uniform", "normal", "sequential"};
+
+static void clientResume(LoopSim *sim, const int index);
+static void dispatch(LoopSim *sim);
+
+static void pendingInit(PendingSet *set);
+static void pendingFree(PendingSet *set);
+static void pendingAdd(LoopSim *sim, const int index);
+static int pendingTake(LoopSim *sim);
+static int pendingTakeCylinder(LoopSim *sim, const int cylinder);
+static int nextCylinderAtOrAbove(const PendingSet *set, const int cylinder);
+static int nextCylinderAtOrBelow(const PendingSet *set, const int cylinder);
+
+static unsigned int nextRandom(unsigned int *state);
+static double uniformRandom(unsigned int *state);
+static double thinkTime(const LoopConfig *config, Client *client);
+static int nextCylinder(const LoopConfig *config, Client *client);
+static double serviceTime(const LoopConfig *config, const int distance);
+
+LoopConfig loopConfigFromEnv(const int clients)
+{
+    long start = envLong("D_POS_INIT", D_POS_INIT);
+
+    LoopConfig config = {
+        .clients = clients,
+        .requests = envLong("D_LOOP_REQUESTS", LOOP_REQUESTS),
+        .thinkTime = envDouble("D_THINK", LOOP_THINK_TIME),
+        .distribution = LOOP_UNIFORM,
+        .seed = (unsigned int)envLong("D_SEED", time(NULL)),
+        .start = D_POS_INIT,
+        .settleTime = envDouble("D_SEEK_SETTLE", 1.0),
+        .cylinderTime = envDouble("D_SEEK_CYL", 0.0001),
+        .rotationTime = envDouble("D_ROTATION", 4.17),
+    };
+
+    const char *distribution = getenv("D_LOOP_DIST");
+    if (distribution != NULL)
+    {
+        if (streq(distribution, "normal"))
+            config.distribution = LOOP_NORMAL;
+        else if (streq(distribution, "sequential"))
+            config.distribution = LOOP_SEQUENTIAL;
+        else if (!streq(distribution, "uniform"))
+            fprintf(stderr, "Unknown distribution: %s\n", distribution);
+    }
+
+    // The pending set is indexed by cylinder, so the head has to be on
+    // the disk.
+    if (D_SIZE_MIN <= start && start <= D_SIZE_MAX)
+        config.start = start;
+    else
+        fprintf(stderr, "Starting position out of range: %ld\n", start);
+
+    // A zero seed would leave xorshift stuck at zero.
+    if (config.seed == 0)
+        config.seed = 1;
+
+    return config;
+}
+
+LoopResult runClosedLoop(const LoopConfig *config, const LoopPolicy policy,
+                         EventQueue *events)
+{
+    LoopSim sim = {
+        .config = config,
+        .policy = policy,
+        .clients = safe_malloc(sizeof(Client) * config->clients),
+        .events = events,
+        .up = true,
+        .head = config->start,
+    };
+
+    pendingInit(&sim.pending);
+    eventQueueClear(events);
+
+    // Every client gets its own stream, so each policy sees the same
+    // requests and think times.
+    for (int i = 0; i < config->clients; i++)
+    {
+        Client *client = &sim.clients[i];
+        client->random = config->seed * 2654435761u + i * 40503u + 1;
+        if (client->random == 0)
+            client->random = 1;
+        client->cylinder = nextRandom(&client->random) % CYLINDERS;
+        client->line = 0;
+        client->next = NONE;
+
+        clientResume(&sim, i);
+    }
+
+    Event event;
+
+    while (sim.completed < config->requests &&
+           eventQueuePop(sim.events, &event))
+    {
+        sim.handled++;
+        sim.now = event.time;
+
+        if (event.kind == EVENT_COMPLETION)
+            sim.busy = false;
+
+        clientResume(&sim, event.index);
+
+        // Dispatch the next request whenever the disk falls idle.
+        if (!sim.busy && sim.pending.length > 0)
+            dispatch(&sim);
+    }
+
+    LoopResult result = {
+        .completed = sim.completed,
+        .elapsed = sim.now,
+        .meanResponse = sim.completed > 0 ? sim.responseSum / sim.completed
+                                          : 0,
+        .distance = sim.distance,
+        .events = sim.handled,
+    };
+
+    // Little's law gives the mean number of requests in the system.
+    result.meanQueueDepth = sim.now > 0 ? sim.responseSum / sim.now : 0;
+
+    pendingFree(&sim.pending);
+    free(sim.clients);
+
+    return result;
+}
+
+void closedLoopSweep(const int clients, const int maxClients)
+{
+    LoopConfig config = loopConfigFromEnv(clients);
+
+    printHeader("Closed loop");
+    printf(
+        "Requests per run: %ld\n"
+        "Mean think time: %.3f ms\n"
+        "Distribution: %s\n"
+        "Seed: %u\n",
+        config.requests, config.thinkTime,
+        distributionNames[config.distribution], config.seed);
+
+    printHeader("Throughput versus concurrency");
+    printf("clients,algorithm,throughput (req/s),mean response (ms),"
+           "mean queue depth,total distance\n");
+
+    long events = 0;
+    clock_t began = clock();
+
+    // One queue serves every run, grown to the largest.
+    EventQueue queue;
+    eventQueueInit(&queue, maxClients + 1);
+
+    for (int count = clients; count <= maxClients;)
+    {
+        config.clients = count;
+
+        for (int policy = 0; policy < LOOP_POLICIES; policy++)
+        {
+            LoopResult result = runClosedLoop(&config, policy, &queue);
+            double throughput =
+                result.elapsed > 0 ? result.completed / (result.elapsed / 1000)
+                                   : 0;
+
+            printf("%d,%s,%.2f,%.4f,%.4f,%ld\n", count, policyKeys[policy],
+                   throughput, result.meanResponse, result.meanQueueDepth,
+                   result.distance);
+
+            events += result.events;
+        }
+
+        // Double the concurrency each step, landing on the maximum.
+        if (count == maxClients)
+            break;
+        count = count * 2 < maxClients ? count * 2 : maxClients;
+    }
+
+    double seconds = (clock() - began) / (double)CLOCKS_PER_SEC;
+
+    eventQueueFree(&queue);
+
+    printHeader("Engine");
+    printf(
+        "Memory per client: %zu bytes\n"
+        "Simulated events: %ld\n"
+        "Events per second: %.0f\n"
+        "\n",
+        sizeof(Client) + EVENT_SLOT_BYTES, events,
+        seconds > 0 ? events / seconds : 0);
+}
+
+static void clientResume(LoopSim *sim, const int index)
+{
+    Client *client = &sim->clients[index];
+
+    CO_BEGIN(client->line);
+
+    for (;;)
+    {
+        // Think, then come back once the timer fires.
+        eventQueuePush(sim->events,
+                       sim->now + thinkTime(sim->config, client), index,
+                       EVENT_RESUME);
+        CO_YIELD(client->line);
+
+        // Issue a request and sleep until the disk has served it.
+        client->cylinder = nextCylinder(sim->config, client);
+        client->issued = sim->now;
+        pendingAdd(sim, index);
+        CO_YIELD(client->line);
+
+        sim->completed++;
+        sim->responseSum += sim->now - client->issued;
+    }
+
+    CO_END(client->line);
+}
+
+static void dispatch(LoopSim *sim)
+{
+    int index = pendingTake(sim);
+    Client *client = &sim->clients[index];
+
+    int distance = abs(client->cylinder - sim->head);
+    sim->distance += distance;
+    sim->head = client->cylinder;
+    sim->busy = true;
+
+    eventQueuePush(sim->events,
+                   sim->now + serviceTime(sim->config, distance), index,
+                   EVENT_COMPLETION);
+}
+
+static void pendingInit(PendingSet *set)
+{
+    set->first = safe_malloc(sizeof(int) * CYLINDERS);
+    set->last = safe_malloc(sizeof(int) * CYLINDERS);
+
+    for (int i = 0; i < CYLINDERS; i++)
+        set->first[i] = set->last[i] = NONE;
+
+    memset(set->words, 0, sizeof(set->words));
+    memset(set->summary, 0, sizeof(set->summary));
+    set->fifoFirst = set->fifoLast = NONE;
+    set->length = 0;
+}
+
+static void pendingFree(PendingSet *set)
+{
+    free(set->first);
+    free(set->last);
+}
+
+static void pendingAdd(LoopSim *sim, const int index)
+{
+    PendingSet *set = &sim->pending;
+    Client *client = &sim->clients[index];
+
+    client->next = NONE;
+    set->length++;
+
+    // First come, first served only needs arrival order.
+    if (sim->policy == LOOP_FCFS)
+    {
+        if (set->fifoLast == NONE)
+            set->fifoFirst = index;
+        else
+            sim->clients[set->fifoLast].next = index;
+        set->fifoLast = index;
+        return;
+    }
+
+    int cylinder = client->cylinder - D_SIZE_MIN;
+
+    if (set->last[cylinder] == NONE)
+    {
+        set->first[cylinder] = index;
+        set->words[cylinder / 64] |= 1ull << (cylinder % 64);
+        set->summary[cylinder / 4096] |= 1ull << (cylinder / 64 % 64);
+    }
+    else
+    {
+        sim->clients[set->last[cylinder]].next = index;
+    }
+
+    set->last[cylinder] = index;
+}
+
+static int pendingTake(LoopSim *sim)
+{
+    PendingSet *set = &sim->pending;
+
+    if (sim->policy == LOOP_FCFS)
+    {
+        int index = set->fifoFirst;
+        set->fifoFirst = sim->clients[index].next;
+        if (set->fifoFirst == NONE)
+            set->fifoLast = NONE;
+        set->length--;
+        return index;
+    }
+
+    int head = sim->head - D_SIZE_MIN;
+    int above = nextCylinderAtOrAbove(set, head);
+    int below = nextCylinderAtOrBelow(set, head);
+
+    if (sim->policy == LOOP_SSTF)
+    {
+        if (above == NONE)
+            return pendingTakeCylinder(sim, below);
+        if (below == NONE)
+            return pendingTakeCylinder(sim, above);
+
+        // Equal distances go to whichever request has waited longer.
+        int upDistance = above - head;
+        int downDistance = head - below;
+
+        if (upDistance == downDistance)
+        {
+            Client *up = &sim->clients[set->first[above]];
+            Client *down = &sim->clients[set->first[below]];
+            return pendingTakeCylinder(
+                sim, up->issued <= down->issued ? above : below);
+        }
+
+        return pendingTakeCylinder(sim,
+                                   upDistance < downDistance ? above : below);
+    }
+
+    // Elevator: keep going the same way until nothing is left that way.
+    if (sim->up ? above == NONE : below == NONE)
+        sim->up = !sim->up;
+
+    return pendingTakeCylinder(sim, sim->up ? above : below);
+}
+
+static int pendingTakeCylinder(LoopSim *sim, const int cylinder)
+{
+    PendingSet *set = &sim->pending;
+
+    int index = set->first[cylinder];
+    set->first[cylinder] = sim->clients[index].next;
+    set->length--;
+
+    if (set->first[cylinder] == NONE)
+    {
+        set->last[cylinder] = NONE;
+        set->words[cylinder / 64] &= ~(1ull << (cylinder % 64));
+
+        if (set->words[cylinder / 64] == 0)
+            set->summary[cylinder / 4096] &= ~(1ull << (cylinder / 64 % 64));
+    }
+
+    return index;
+}
+
+static int nextCylinderAtOrAbove(const PendingSet *set, const int cylinder)
+{
+    assert(D_SIZE_MIN <= cylinder && cylinder <= D_SIZE_MAX);
+
+    int word = cylinder / 64;
+    unsigned long long bits = set->words[word] & (~0ull << (cylinder % 64));
+
+    if (bits)
+        return word * 64 + __builtin_ctzll(bits);
+
+    // Find the next non-empty word through the summary.
+    for (int group = (word + 1) / 64, from = (word + 1) % 64;
+         group < SUMMARY_WORDS; group++, from = 0)
+    {
+        unsigned long long words = set->summary[group] & (~0ull << from);
+
+        if (words)
+        {
+            word = group * 64 + __builtin_ctzll(words);
+            return word * 64 + __builtin_ctzll(set->words[word]);
+        }
+    }
+
+    return NONE;
+}
+
+static int nextCylinderAtOrBelow(const PendingSet *set, const int cylinder)
+{
+    assert(D_SIZE_MIN <= cylinder && cylinder <= D_SIZE_MAX);
+
+    int word = cylinder / 64;
+    unsigned long long bits =
+        set->words[word] & (~0ull >> (63 - cylinder % 64));
+
+    if (bits)
+        return word * 64 + 63 - __builtin_clzll(bits);
+
+    if (word == 0)
+        return NONE;
+
+    // Find the previous non-empty word through the summary.
+    for (int group = (word - 1) / 64, to = (word - 1) % 64; group >= 0;
+         group--, to = 63)
+    {
+        unsigned long long words = set->summary[group] & (~0ull >> (63 - to));
+
+        if (words)
+        {
+            word = group * 64 + 63 - __builtin_clzll(words);
+            return word * 64 + 63 - __builtin_clzll(set->words[word]);
+        }
+    }
+
+    return NONE;
+}
+
+static unsigned int nextRandom(unsigned int *state)
+{
+    // xorshift32
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double uniformRandom(unsigned int *state)
+{
+    return nextRandom(state) / 4294967296.0;
+}
+
+static double thinkTime(const LoopConfig *config, Client *client)
+{
+    // Exponentially distributed around the configured mean
+    return -config->thinkTime * log(1 - uniformRandom(&client->random));
+}
+
+static int nextCylinder(const LoopConfig *config, Client *client)
+{
+    int cylinder;
+
+    switch (config->distribution)
+    {
+    case LOOP_NORMAL:
+    {
+        // Box-Muller, centred on the middle of the disk
+        double u = 1 - uniformRandom(&client->random);
+        double v = uniformRandom(&client->random);
+        double z = sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+        cylinder = (int)lround(D_POS_INIT + z * (D_SIZE_MAX / 8.0));
+
+        if (cylinder < D_SIZE_MIN)
+            cylinder = D_SIZE_MIN;
+        if (cylinder > D_SIZE_MAX)
+            cylinder = D_SIZE_MAX;
+        break;
+    }
+    case LOOP_SEQUENTIAL:
+        cylinder = client->cylinder < D_SIZE_MAX ? client->cylinder + 1
+                                               : D_SIZE_MIN;
+        break;
+    default:
+        cylinder = D_SIZE_MIN +
+                   (int)(nextRandom(&client->random) %
+                         (D_SIZE_MAX - D_SIZE_MIN + 1));
+    }
+
+    return cylinder;
+}
+
+static double serviceTime(const LoopConfig *config, const int distance)
+{
+    double time = config->rotationTime;
+
+    if (distance > 0)
+        time += config->settleTime + distance * config->cylinderTime;
+
+    return time;
+}
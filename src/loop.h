@@ -0,0 +1,59 @@
+/**
+ * Closed-loop workload simulation
+ *
+ * @file loop.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef LOOP_H
+#define LOOP_H
+
+#include "engine.h"
+
+typedef enum LoopPolicy
+{
+    LOOP_FCFS,
+    LOOP_SSTF,
+    LOOP_ELEVATOR,
+    LOOP_POLICIES
+} LoopPolicy;
+
+typedef enum LoopDistribution
+{
+    LOOP_UNIFORM,
+    LOOP_NORMAL,
+    LOOP_SEQUENTIAL
+} LoopDistribution;
+
+typedef struct LoopConfig
+{
+    int clients;
+    long requests;
+    double thinkTime;
+    LoopDistribution distribution;
+    unsigned int seed;
+    int start;
+
+    // Service time model (milliseconds)
+    double settleTime;
+    double cylinderTime;
+    double rotationTime;
+} LoopConfig;
+
+typedef struct LoopResult
+{
+    long completed;
+    double elapsed;
+    double meanResponse;
+    double meanQueueDepth;
+    long distance;
+    long events;
+} LoopResult;
+
+LoopConfig loopConfigFromEnv(const int clients);
+LoopResult runClosedLoop(const LoopConfig *config, const LoopPolicy policy,
+                         EventQueue *events);
+void closedLoopSweep(const int clients, const int maxClients);
+
+#endif
@@ -9,78 +9,128 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 #include <limits.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "loop.h"
+#include "bench.h"
+#include "replay.h"
+#include "batch.h"
+#include "blkimport.h"
+#include "merge.h"
+#include "trace.h"
+#include "statcache.h"
+#include "parse.h"
+#include "pipeline.h"
+#include "writer.h"
+#include "follow.h"
+#include "shmring.h"
+#include "oracle.h"
+#include "plugin.h"
+#include "fastsched.h"
+#include "verify.h"
+#include "permcheck.h"
+#include "histogram.h"
+#include "distance.h"
+
+void generateRandomSeeks(const int number, RequestTable *requests);
+
+void printOverview(const Simulation *sim, SeekList seeks, bool final);
+void printRunStats(SeekList seeks, const char title[], const int start);
+void printConclusion(const Simulation *sim);
+void printStreamTotals(const Simulation *sim, const char title[]);
+
+Scheduler schedulers[SCHEDULERS_MAX] = {
+    {"First come, first served", "fcfs", firstComeFirstServed},
+    {"Shortest seek first", "sstf", shortestSeekFirst},
+    {"Elevator algorithm", "elevator", elevatorAlgorithm},
+};
+
+int schedulerCount = BUILTIN_SCHEDULERS;
 
-#define D_SIZE_MIN 0
-#define D_SIZE_MAX 65535
-#define D_POS_INIT 32767
-#define CHUNK true
-
-#define D_DYNAMIC_BASE_SIZE 10
-
-#define safe_malloc(size) _safe_malloc(size, __FILE__, __LINE__)
-#define safe_realloc(ptr, size) _safe_realloc(ptr, size, __FILE__, __LINE__)
-
-typedef struct SeekList
+int main(int argc, char *argv[])
 {
-    int *list;
-    int length;
-} SeekList;
-
-bool streq(const char *a, const char *b);
-int min(const int a, const int b);
-int randint(const int min, const int max);
-
-void *_safe_malloc(const size_t size, const char *file, const int line);
-void *_safe_realloc(void *ptr, const size_t size, const char *file,
-                    const int line);
-
-void printHeader(const char text[]);
-void printIntList(const int list[], const int length);
-
-SeekList generateRandomSeeks(const int number);
-SeekList extractSeeks(FILE *stream);
-
-void firstComeFirstServed(SeekList *seeks);
-void shortestSeekFirst(SeekList *seeks);
-void elevatorAlgorithm(SeekList *seeks);
-
-void printOverview(SeekList seeks, bool final);
-void printRunStats(SeekList seeks, const char title[]);
-void printConclusion();
+    // Plugins come ahead of the command so that every command sees them.
+    while (argc > 2 && streq(argv[1], "--plugin"))
+    {
+        if (!loadPlugin(argv[2]))
+            return EXIT_FAILURE;
 
-void processChunk(SeekList chunk);
-void processInChunks(SeekList seeks);
-void process(SeekList seeks);
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
 
-int currentStart = -1;
-int firstComeStart = D_POS_INIT;
-int firstComeTally = 0;
-int shortestStart = D_POS_INIT;
-int shortestTally = 0;
-int elevatorStart = D_POS_INIT;
-int elevatorTally = 0;
+    // Only chunks longer than D_CHUNK_SIZE ever reach them; see fastsched.h.
+    if (envLong("D_FAST_SCHEDULERS", 0))
+        useFastSchedulers();
 
-int main(int argc, char *argv[])
-{
     if (argc < 2)
     {
         printf(
-            "Usage: %s <command>\n"
+            "Usage: %s [--plugin <path.so>]... <command>\n"
+            "\n"
+            "Options:\n"
+            "--plugin <path.so>\n"
+            "               –   add the schedulers in a plugin built against\n"
+            "                   dassplugin.h to the built-in ones\n"
             "\n"
             "Commands:\n"
             "file <path>    –   read disk seeks from file at path\n"
             "in             –   read disk seeks from stdin\n"
-            "rand <number>  –   use given number of random disk seeks\n",
+            "blk <path|->   –   import a blktrace or blkparse trace\n"
+            "merge <path>...\n"
+            "               –   merge blktrace or blkparse traces by\n"
+            "                   timestamp and simulate the combined stream\n"
+            "rand <number>  –   use given number of random disk seeks\n"
+            "loop <clients> [max clients]\n"
+            "               –   run a closed-loop workload with the given\n"
+            "                   number of clients (or sweep up to max)\n"
+            "bench          –   run the benchmark suite\n"
+            "verify [rounds] [seed]\n"
+            "               –   check the fast schedulers against the\n"
+            "                   originals on random workloads\n"
+            "replay <path> <target> [depth]\n"
+            "               –   issue each scheduler's order of the seeks\n"
+            "                   in path as reads against a file or device\n"
+            "batch <dir|list> [report]\n"
+            "               –   process every trace in a directory or list\n"
+            "                   in parallel and write a JSON report\n"
+            "convert <in> <out>\n"
+            "               –   compress a text trace, or expand a\n"
+            "                   compressed one back to text\n"
+            "pipe <path|->  –   read, schedule and print a trace on\n"
+            "                   separate threads\n"
+            "follow <path>  –   simulate a trace as it is written, with\n"
+            "                   periodic running totals\n"
+            "shm <name>     –   simulate requests written to a shared-memory\n"
+            "                   ring by a local producer\n"
+            "shm-feed <name> [path|-]\n"
+            "               –   write a text trace into a shared-memory ring\n"
+            "serve <socket> –   answer scheduling requests from other\n"
+            "                   programs over a Unix domain socket\n"
+            "ask <socket> <scheduler> <head> <cylinder>...\n"
+            "               –   ask a running server for one schedule\n"
+            "stat <path> [first] [count]\n"
+            "               –   summarise a compressed trace, or a range of\n"
+            "                   its requests, from its block index\n",
             argv[0]);
     }
     else
     {
         const char *command = argv[1];
 
-        SeekList seeks;
+        RequestTable requests;
+        requestTableInit(&requests, D_DYNAMIC_BASE_SIZE);
+
+        // Set when the seeks come from a file that can carry a sidecar
+        const char *tracePath = NULL;
+        StatCache *statCache = NULL;
 
         if (streq(command, "file"))
         {
@@ -89,28 +139,60 @@ int main(int argc, char *argv[])
                 printf("Usage: %s file <path>\n", argv[0]);
                 return EXIT_FAILURE;
             }
-            else
+            else if (isCompressedTrace(argv[2]))
             {
-                const char *path = argv[2];
-
-                FILE *file = fopen(path, "r");
+                // Decoded block by block rather than loaded whole
+                requestTableFree(&requests);
+                return simulateCompressed(argv[2]) ? EXIT_SUCCESS
+                                                   : EXIT_FAILURE;
+            }
 
-                if (file != NULL)
-                {
-                    seeks = extractSeeks(file);
-                }
-                else
-                {
-                    fprintf(stderr, "Could not open file: %s\n", path);
-                    return EXIT_FAILURE;
-                }
+            // A current sidecar already holds the histogram, so the trace
+            // needn't be counted as it's read.
+            statCache = statCacheFind(argv[2]);
+            if (statCache != NULL)
+            {
+                free(requests.histogram);
+                requests.histogram = NULL;
+            }
 
-                fclose(file);
+            if (!readSeekFile(argv[2], &requests))
+            {
+                free(statCache);
+                return EXIT_FAILURE;
             }
+
+            tracePath = argv[2];
         }
         else if (streq(command, "in"))
         {
-            seeks = extractSeeks(stdin);
+            if (!extractSeeks(stdin, "stdin", &requests))
+                return EXIT_FAILURE;
+        }
+        else if (streq(command, "blk"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s blk <path|->\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const char *path = argv[2];
+            FILE *stream = streq(path, "-") ? stdin : fopen(path, "rb");
+
+            if (stream == NULL)
+            {
+                fprintf(stderr, "Could not open file: %s\n", path);
+                return EXIT_FAILURE;
+            }
+
+            bool imported = importBlktrace(stream, &requests);
+
+            if (stream != stdin)
+                fclose(stream);
+
+            if (!imported)
+                return EXIT_FAILURE;
         }
         else if (streq(command, "rand"))
         {
@@ -122,8 +204,232 @@ int main(int argc, char *argv[])
             else
             {
                 const int number = atoi(argv[2]);
-                seeks = generateRandomSeeks(number);
+                generateRandomSeeks(number, &requests);
+            }
+        }
+        else if (streq(command, "loop"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s loop <clients> [max clients]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const int clients = atoi(argv[2]);
+            const int maxClients = argc > 3 ? atoi(argv[3]) : clients;
+
+            if (clients < 1 || maxClients < clients)
+            {
+                fprintf(stderr, "Invalid client count.\n");
+                return EXIT_FAILURE;
+            }
+
+            closedLoopSweep(clients, maxClients);
+            return EXIT_SUCCESS;
+        }
+        else if (streq(command, "bench"))
+        {
+            runBenchmarks();
+            return EXIT_SUCCESS;
+        }
+        else if (streq(command, "replay"))
+        {
+            if (argc < 4)
+            {
+                printf("Usage: %s replay <path> <target> [depth]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const int depth = argc > 4 ? atoi(argv[4]) : 1;
+
+            if (depth < 1)
+            {
+                fprintf(stderr, "Invalid queue depth.\n");
+                return EXIT_FAILURE;
+            }
+
+            if (!readSeekFile(argv[2], &requests))
+                return EXIT_FAILURE;
+
+            int status = replay(requestTableSeeks(&requests), argv[3], depth)
+                             ? EXIT_SUCCESS
+                             : EXIT_FAILURE;
+            requestTableFree(&requests);
+            return status;
+        }
+        else if (streq(command, "merge"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s merge <path>...\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return mergeTraces(&argv[2], argc - 2) ? EXIT_SUCCESS
+                                                   : EXIT_FAILURE;
+        }
+        else if (streq(command, "convert"))
+        {
+            if (argc < 4)
+            {
+                printf("Usage: %s convert <in> <out>\n", argv[0]);
+                return EXIT_FAILURE;
             }
+
+            requestTableFree(&requests);
+            return convertTrace(argv[2], argv[3]) ? EXIT_SUCCESS
+                                                  : EXIT_FAILURE;
+        }
+        else if (streq(command, "stat"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s stat <path> [first] [count]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const long long first = argc > 3 ? atoll(argv[3]) : 0;
+            const long long count = argc > 4 ? atoll(argv[4]) : LLONG_MAX;
+
+            if (first < 0 || count < 0)
+            {
+                fprintf(stderr, "Invalid request range.\n");
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return printTraceStats(argv[2], first, count) ? EXIT_SUCCESS
+                                                          : EXIT_FAILURE;
+        }
+        else if (streq(command, "pipe"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s pipe <path|->\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const char *path = argv[2];
+            FILE *stream = streq(path, "-") ? stdin : fopen(path, "r");
+
+            if (stream == NULL)
+            {
+                fprintf(stderr, "Could not open file: %s\n", path);
+                return EXIT_FAILURE;
+            }
+
+            bool ok = runPipeline(stream, streq(path, "-") ? "stdin" : path);
+
+            if (stream != stdin)
+                fclose(stream);
+
+            requestTableFree(&requests);
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "follow"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s follow <path>\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return followTrace(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "shm"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s shm <name>\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return consumeShmRing(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "shm-feed"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s shm-feed <name> [path|-]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const char *path = argc > 3 ? argv[3] : "-";
+            FILE *stream = streq(path, "-") ? stdin : fopen(path, "r");
+
+            if (stream == NULL)
+            {
+                fprintf(stderr, "Could not open file: %s\n", path);
+                return EXIT_FAILURE;
+            }
+
+            bool ok = feedShmRing(argv[2], stream,
+                                  streq(path, "-") ? "stdin" : path);
+
+            if (stream != stdin)
+                fclose(stream);
+
+            requestTableFree(&requests);
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "verify"))
+        {
+            const int rounds = argc > 2 ? atoi(argv[2]) : VERIFY_ROUNDS;
+            const unsigned seed = argc > 3 ? strtoul(argv[3], NULL, 10)
+                                           : (unsigned)time(NULL);
+
+            requestTableFree(&requests);
+            return verifySchedulers(rounds, seed) ? EXIT_SUCCESS
+                                                  : EXIT_FAILURE;
+        }
+        else if (streq(command, "serve"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s serve <socket>\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return serveOracle(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "ask"))
+        {
+            if (argc < 5)
+            {
+                printf("Usage: %s ask <socket> <scheduler> <head> "
+                       "<cylinder>...\n",
+                       argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            const int count = argc - 5;
+            int *cylinders = safe_malloc(sizeof(int) * (count + 1));
+
+            for (int i = 0; i < count; i++)
+                cylinders[i] = atoi(argv[i + 5]);
+
+            bool ok = askOracle(argv[2], argv[3], atoi(argv[4]), cylinders,
+                                count);
+
+            free(cylinders);
+            requestTableFree(&requests);
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if (streq(command, "batch"))
+        {
+            if (argc < 3)
+            {
+                printf("Usage: %s batch <dir|list> [report]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            requestTableFree(&requests);
+            return batch(argv[2], argc > 3 ? argv[3] : NULL) ? EXIT_SUCCESS
+                                                             : EXIT_FAILURE;
         }
         else
         {
@@ -131,15 +437,29 @@ int main(int argc, char *argv[])
             return EXIT_FAILURE;
         }
 
+        // The schedulers only ever see the cylinder column.
+        SeekList seeks = requestTableSeeks(&requests);
+
         if (seeks.list != NULL)
         {
-            process(seeks);
-            free(seeks.list);
+            Simulation sim;
+            simulationInit(&sim);
+            sim.histogram = requests.histogram;
+
+            if (tracePath != NULL)
+                statCache = statCacheApply(&sim, tracePath, seeks, statCache);
+
+            process(&sim, seeks);
+            simulationFree(&sim);
         }
         else
         {
             fprintf(stderr, "Failed to create list of disk seeks.\n");
         }
+
+        free(statCache);
+
+        requestTableFree(&requests);
     }
 }
 
@@ -154,78 +474,199 @@ bool streq(const char *a, const char *b)
     return *b == '\0';
 }
 
-SeekList generateRandomSeeks(const int number)
+void generateRandomSeeks(const int number, RequestTable *requests)
 {
-    int *seeks = safe_malloc(number * sizeof(int));
-
     srand(time(NULL));
 
     for (int i = 0; i < number; i++)
-        seeks[i] = randint(D_SIZE_MIN, D_SIZE_MAX);
-
-    return (SeekList){seeks, number};
+        requestTableAppend(requests, randint(D_SIZE_MIN, D_SIZE_MAX));
 }
 
-SeekList extractSeeks(FILE *stream)
+bool extractSeeks(FILE *stream, const char *source, RequestTable *requests)
 {
-    int size = D_DYNAMIC_BASE_SIZE;
-    int *seeks = safe_malloc(sizeof(int) * size);
+    Validation validation;
+    validationInit(&validation);
 
-    int seek;
-    int number = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    int *seeks = NULL;
+    int seeksCapacity = 0;
+    ssize_t length;
 
-    while (fscanf(stream, "%d\n", &seek) == 1)
+    while (!validation.failed &&
+           (length = getline(&line, &capacity, stream)) > 0)
     {
-        if (number == size)
+        // Every seek takes at least a digit and a separator.
+        if (length / 2 + 1 > seeksCapacity)
         {
-            size *= 2;
-            seeks = safe_realloc(seeks, sizeof(int) * size);
+            seeksCapacity = length / 2 + 1;
+            seeks = safe_realloc(seeks, sizeof(int) * seeksCapacity);
         }
 
-        if (D_SIZE_MIN <= seek && seek <= D_SIZE_MAX)
-        {
-            seeks[number++] = seek;
-        }
-        else
-        {
-            fprintf(stderr, "\nSeek out of bounds: %d\n\n", seek);
-        }
+        int count = parseSeekText(line, line + length, seeks, &validation);
+        requestTableAppendMany(requests, seeks, count);
     }
 
-    return (SeekList){seeks, number};
+    free(line);
+    free(seeks);
+
+    return validationReport(&validation, source);
 }
 
-void process(SeekList seeks)
+bool readSeekFile(const char *path, RequestTable *requests)
+{
+    struct stat info;
+
+    // Large text traces are parsed across threads.
+    if (stat(path, &info) == 0 && info.st_size >= PARSE_PARALLEL_MIN &&
+        !isCompressedTrace(path))
+    {
+        return parseSeekFile(path, requests);
+    }
+
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "Could not open file: %s\n", path);
+        return false;
+    }
+
+    bool ok;
+
+    if (isCompressedTrace(path))
+        ok = readCompressedTrace(file, requests);
+    else
+        ok = extractSeeks(file, path, requests);
+
+    fclose(file);
+
+    return ok;
+}
+
+void simulationInit(Simulation *sim)
+{
+    *sim = (Simulation){
+        .elevatorUp = true,
+        .elevatorPolicy = ELEVATOR_UP,
+    };
+
+    for (int i = 0; i < schedulerCount; i++)
+        sim->states[i].start = D_POS_INIT;
+
+    configure(sim);
+}
+
+void process(Simulation *sim, SeekList seeks)
+{
+    writerStart(sim);
+
+#if CHUNK == true
+    processInChunks(sim, seeks);
+#else
+    processChunk(sim, seeks);
+#endif
+
+    writerStop(sim);
+    distanceLogClose(sim);
+    printOverview(sim, seeks, true);
+}
+
+void configure(Simulation *sim)
 {
     // Starting position
     const char *initialPositionInput = getenv("D_POS_INIT");
     if (initialPositionInput != NULL)
     {
         int start = atoi(initialPositionInput);
-        firstComeStart = start;
-        shortestStart = start;
-        elevatorStart = start;
+
+        for (int i = 0; i < schedulerCount; i++)
+            sim->states[i].start = start;
     }
 
-#if CHUNK == true
-    processInChunks(seeks);
-#else
-    processChunk(seeks);
-#endif
+    // Initial elevator direction
+    const char *elevatorPolicyInput = getenv("D_ELEVATOR_DIR");
+    if (elevatorPolicyInput != NULL)
+    {
+        if (streq(elevatorPolicyInput, "up"))
+            sim->elevatorPolicy = ELEVATOR_UP;
+        else if (streq(elevatorPolicyInput, "nearer"))
+            sim->elevatorPolicy = ELEVATOR_NEARER;
+        else if (streq(elevatorPolicyInput, "denser"))
+            sim->elevatorPolicy = ELEVATOR_DENSER;
+        else
+            fprintf(stderr, "Unknown elevator direction policy: %s\n",
+                    elevatorPolicyInput);
+    }
+
+    sim->checkSchedules = envLong("D_CHECK_SCHEDULES", 0) != 0;
+    sim->distanceLogPath = getenv("D_DISTANCE_LOG");
+}
+
+void simulationFeed(Simulation *sim, const int seek)
+{
+    simulationCount(sim, seek);
+    simulationQueue(sim, seek);
+}
+
+void simulationCount(Simulation *sim, const int seek)
+{
+    sim->seekCount++;
+    sim->seekSum += seek;
+    sim->seekSumOfSquares += (double)seek * seek;
+
+    if (sim->histogram == NULL)
+        sim->histogram = histogramCreate();
+    histogramAdd(sim->histogram, seek);
+}
 
-    printOverview(seeks, true);
+void simulationQueue(Simulation *sim, const int seek)
+{
+    sim->chunk[sim->chunkLength++] = seek;
+
+    if (sim->chunkLength == D_CHUNK_SIZE)
+    {
+        processChunk(sim, (SeekList){sim->chunk, sim->chunkLength});
+        sim->chunkLength = 0;
+    }
+}
+
+void simulationFinish(Simulation *sim)
+{
+    // The last chunk may be short.
+    if (sim->chunkLength > 0)
+    {
+        processChunk(sim, (SeekList){sim->chunk, sim->chunkLength});
+        sim->chunkLength = 0;
+    }
+
+    writerStop(sim);
+    distanceLogClose(sim);
+
+    if (!sim->quiet)
+        printStreamConclusion(sim);
+
+    free(sim->histogram);
+    sim->histogram = NULL;
+
+    simulationFree(sim);
+}
+
+void simulationFree(Simulation *sim)
+{
+    pluginStatesFree(sim);
 }
 
-void processInChunks(SeekList seeks)
+void processInChunks(Simulation *sim, SeekList seeks)
 {
     // I worked out my basic structure before the instructions were
     // updated. I was planning to just process all the requests in one
     // go. Hopefully this addition emulates the sort of table required.
-    int buffer[100];
+    int buffer[D_BUFFER_SIZE];
     int remaining = seeks.length;
     int seekIndex = 0;
 
-    for (; seekIndex < min(100, remaining); seekIndex++)
+    for (; seekIndex < min(D_BUFFER_SIZE, remaining); seekIndex++)
     {
         buffer[seekIndex] = seeks.list[seekIndex];
     }
@@ -233,15 +674,16 @@ void processInChunks(SeekList seeks)
     while (remaining)
     {
         // Select the next chunk.
-        int chunkSize = min(20, remaining);
+        int chunkSize = min(D_CHUNK_SIZE, remaining);
         SeekList chunk = {buffer, chunkSize};
 
         // Process chunk.
-        processChunk(chunk);
+        processChunk(sim, chunk);
 
         // Shift buffer content.
         int shiftIndex = chunkSize;
-        for (; shiftIndex < 100 && shiftIndex < remaining; shiftIndex++)
+        for (; shiftIndex < D_BUFFER_SIZE && shiftIndex < remaining;
+             shiftIndex++)
         {
             buffer[shiftIndex - chunkSize] = buffer[shiftIndex];
         }
@@ -250,33 +692,92 @@ void processInChunks(SeekList seeks)
         remaining -= chunkSize;
 
         // Refill buffer.
-        for (int i = shiftIndex - chunkSize; i < 100 && i < remaining; i++)
+        for (int i = shiftIndex - chunkSize;
+             i < D_BUFFER_SIZE && i < remaining; i++)
         {
             buffer[i] = seeks.list[seekIndex++];
         }
     }
 }
 
-void processChunk(SeekList seeks)
+void processChunk(Simulation *sim, SeekList seeks)
 {
+    // Results printed elsewhere are copied out as the chunk changes.
+    ChunkResult result;
+    bool emitting = sim->emit != NULL && seeks.length <= D_CHUNK_SIZE;
+
     // Overview
-    printOverview(seeks, false);
+    if (emitting)
+    {
+        result.length = seeks.length;
+        memcpy(result.seeks, seeks.list, sizeof(int) * seeks.length);
+    }
+    else if (!sim->quiet)
+    {
+        printOverview(sim, seeks, false);
+    }
+
+    sim->chunks++;
+
+    if (sim->checkSchedules)
+        sim->schedulesChecked++;
+
+    bool logging = sim->distanceLogPath != NULL && !sim->quiet;
+
+    // Each algorithm picks up where the previous one left the chunk.
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        SchedulerState *state = &sim->states[i];
+        SchedulerState before = *state;
+        bool elevatorUp = sim->elevatorUp;
+        bool elevatorStarted = sim->elevatorStarted;
+        int elevatorReversals = sim->elevatorReversals;
+        int start = state->start;
+        int offender;
+
+        if (sim->checkSchedules)
+            permutationSave(seeks.list, seeks.length);
+
+        schedulers[i].schedule(sim, state, &seeks);
+
+        // An invalid schedule is undone: the chunk is put back, and the
+        // scheduler's figures are left as they were before it ran.
+        if (sim->checkSchedules && !permutationCheck(seeks.list, &offender))
+        {
+            permutationViolation(sim, i, offender);
 
-    // First come, first served algorithm
-    firstComeFirstServed(&seeks);
-    printRunStats(seeks, "First come, first served");
+            *state = before;
+            sim->elevatorUp = elevatorUp;
+            sim->elevatorStarted = elevatorStarted;
+            sim->elevatorReversals = elevatorReversals;
+        }
 
-    // Shortest seek first algorithm
-    shortestSeekFirst(&seeks);
-    printRunStats(seeks, "Shortest seek first");
+        if (logging)
+            distanceLogChunk(sim, i, &before, seeks.length);
+
+        if (emitting)
+        {
+            result.starts[i] = start;
+            memcpy(result.orders[i], seeks.list, sizeof(int) * seeks.length);
+        }
+        else if (!sim->quiet)
+        {
+            printRunStats(seeks, schedulers[i].title, start);
+        }
+    }
 
-    // Elevator algorithm
-    elevatorAlgorithm(&seeks);
-    printRunStats(seeks, "Elevator algorithm");
+    if (emitting)
+        sim->emit(sim->emitContext, &result);
 }
 
-void printOverview(SeekList seeks, bool final)
+void printOverview(const Simulation *sim, SeekList seeks, bool final)
 {
+    if (final && sim->statsKnown)
+    {
+        printStreamConclusion(sim);
+        return;
+    }
+
     printHeader(final ? "Conclusion" : "Overview");
 
     long sum = 0;
@@ -312,16 +813,50 @@ void printOverview(SeekList seeks, bool final)
         seeks.length, mean, stddev);
 
     if (final) {
-        printConclusion();
+        printDistribution(sim->histogram);
+        printConclusion(sim);
     }
 }
 
-void printRunStats(SeekList seeks, const char title[])
+void printStreamConclusion(const Simulation *sim)
+{
+    printStreamTotals(sim, "Conclusion");
+}
+
+void printRunningTotals(const Simulation *sim)
+{
+    printStreamTotals(sim, "Running totals");
+
+    if (sim->chunkLength > 0)
+        printf("Waiting to fill the next chunk: %d\n\n", sim->chunkLength);
+}
+
+void printStreamTotals(const Simulation *sim, const char title[])
+{
+    printHeader(title);
+
+    // Streams are never held in full, so the statistics come from the
+    // running sums.
+    double count = sim->seekCount;
+    double mean = sim->seekSum / count;
+    double variance = (sim->seekSumOfSquares - sim->seekSum * mean) / count;
+
+    printf(
+        "Total requested seeks: %ld\n"
+        "Mean: %.4f\n"
+        "Standard deviation: %.4f\n",
+        sim->seekCount, mean, sqrt(variance > 0 ? variance : 0));
+
+    printDistribution(sim->histogram);
+    printConclusion(sim);
+}
+
+void printRunStats(SeekList seeks, const char title[], const int start)
 {
     printHeader(title);
 
     int distance = 0;
-    int seekPosition = currentStart;
+    int seekPosition = start;
 
     for (int i = 0; i < seeks.length; i++)
     {
@@ -329,46 +864,69 @@ void printRunStats(SeekList seeks, const char title[])
         seekPosition = seeks.list[i];
     }
 
-    printf("Starting position: %d\n", currentStart);
+    printf("Starting position: %d\n", start);
     printf("Total distance: %d\n", distance);
     printf("\n");
     printIntList(seeks.list, seeks.length);
 }
 
-void printConclusion()
+void printConclusion(const Simulation *sim)
 {
+    static const char *policyNames[] = {"up", "nearer", "denser"};
+
     printHeader("Effective seek counts");
+    for (int i = 0; i < schedulerCount; i++)
+        printf("%s: %d\n", schedulers[i].title, sim->states[i].tally);
+
+    printHeader("Total seek distances");
+    for (int i = 0; i < schedulerCount; i++)
+        printf("%s: %ld\n", schedulers[i].title, sim->states[i].distance);
+
+    printDistanceBuckets(sim);
+
     printf(
-        "First come, first served: %d\n"
-        "Shortest seek first: %d\n"
-        "Elevator algorithm: %d\n"
+        "\n"
+        "Elevator initial direction: %s\n"
+        "Elevator direction reversals: %d\n"
         "\n",
-        firstComeTally, shortestTally, elevatorTally);
+        policyNames[sim->elevatorPolicy], sim->elevatorReversals);
+
+    if (sim->checkSchedules)
+    {
+        printScheduleChecks(sim);
+        printf("\n");
+    }
 }
 
-void firstComeFirstServed(SeekList *seeks)
+void firstComeFirstServed(Simulation *sim, SchedulerState *state,
+                          SeekList *seeks)
 {
-    currentStart = firstComeStart;
+    (void)sim;
 
-    int lastPosition = firstComeStart;
+    int lastPosition = state->start;
 
     for (int i = 0; i < seeks->length; i++)
     {
         if (seeks->list[i] != lastPosition)
         {
-            firstComeTally++;
+            int distance = abs(seeks->list[i] - lastPosition);
+
+            state->tally++;
+            state->distance += distance;
+            state->buckets[distanceBucket(distance)]++;
         }
         lastPosition = seeks->list[i];
     }
 
-    firstComeStart = lastPosition;
+    state->start = lastPosition;
 }
 
-void shortestSeekFirst(SeekList *seeks)
+void shortestSeekFirst(Simulation *sim, SchedulerState *state,
+                       SeekList *seeks)
 {
-    currentStart = shortestStart;
+    (void)sim;
 
-    int seekPosition = shortestStart;
+    int seekPosition = state->start;
 
     for (int i = 0; i < seeks->length; i++)
     {
@@ -399,33 +957,45 @@ void shortestSeekFirst(SeekList *seeks)
 
             if (seekPosition != nextPosition)
             {
+                int distance = abs(nextPosition - seekPosition);
+
+                state->distance += distance;
+                state->buckets[distanceBucket(distance)]++;
                 seekPosition = nextPosition;
-                shortestTally++;
+                state->tally++;
             }
         }
     }
 
-    shortestStart = seekPosition;
+    state->start = seekPosition;
 }
 
-void elevatorAlgorithm(SeekList *seeks)
+void elevatorAlgorithm(Simulation *sim, SchedulerState *state,
+                       SeekList *seeks)
 {
-    bool up = true;
+    // The direction is only chosen once; after that, the head keeps
+    // sweeping whichever way it was last moving.
+    if (!sim->elevatorStarted && seeks->length > 0)
+    {
+        sim->elevatorUp = elevatorInitialDirection(sim, *seeks, state->start);
+        sim->elevatorStarted = true;
+    }
 
-    currentStart = elevatorStart;
+    bool up = sim->elevatorUp;
 
-    int seekPosition = elevatorStart;
+    int start = state->start;
+    int seekPosition = start;
     int index = 0;
 
-    for (int run = 2; run > 0; run--, up = !up)
+    for (int run = 2; run > 0 && index < seeks->length; run--, up = !up)
     {
+        // Requests at the current position are served in either direction.
         for (; index < seeks->length; index++)
         {
-            int lower = up ? seekPosition : INT_MIN;
-            int upper = up ? INT_MAX : seekPosition;
+            int lower = up ? seekPosition - 1 : INT_MIN;
+            int upper = up ? INT_MAX : seekPosition + 1;
 
-            int position = seeks->list[index];
-            int nextIndex = index;
+            int nextIndex = -1;
 
             for (int evalIndex = index; evalIndex < seeks->length; evalIndex++)
             {
@@ -433,40 +1003,105 @@ void elevatorAlgorithm(SeekList *seeks)
 
                 if (lower < evalPosition && evalPosition < upper)
                 {
-                    seekPosition = evalPosition;
                     nextIndex = evalIndex;
 
                     if (up)
                     {
-                        upper = seekPosition;
+                        upper = evalPosition;
                     }
                     else
                     {
-                        lower = seekPosition;
+                        lower = evalPosition;
                     }
                 }
             }
 
+            // Nothing left this way, so turn around.
+            if (nextIndex == -1)
+            {
+                break;
+            }
+
+            int nextPosition = seeks->list[nextIndex];
+
             if (nextIndex != index)
             {
-                seeks->list[index] = seekPosition;
-                seeks->list[nextIndex] = position;
+                seeks->list[nextIndex] = seeks->list[index];
+                seeks->list[index] = nextPosition;
+            }
+
+            // Only a head that has already moved can reverse.
+            bool moved = state->distance > 0 || seekPosition != start;
+
+            if (sim->elevatorUp != up && nextPosition != seekPosition)
+            {
+                if (moved)
+                    sim->elevatorReversals++;
+
+                sim->elevatorUp = up;
             }
+
+            seekPosition = nextPosition;
         }
     }
 
-    seekPosition = elevatorStart;
+    seekPosition = start;
 
     for (int i = 0; i < seeks->length; i++)
     {
         if (seeks->list[i] != seekPosition)
         {
-            elevatorTally++;
+            int distance = abs(seeks->list[i] - seekPosition);
+
+            state->tally++;
+            state->distance += distance;
+            state->buckets[distanceBucket(distance)]++;
         }
         seekPosition = seeks->list[i];
     }
 
-    elevatorStart = seekPosition;
+    state->start = seekPosition;
+}
+
+bool elevatorInitialDirection(const Simulation *sim, SeekList seeks,
+                              const int start)
+{
+    if (sim->elevatorPolicy == ELEVATOR_UP)
+        return true;
+
+    int lowest = INT_MAX;
+    int highest = INT_MIN;
+    int below = 0;
+    int above = 0;
+
+    for (int i = 0; i < seeks.length; i++)
+    {
+        int position = seeks.list[i];
+
+        if (position < lowest)
+            lowest = position;
+        if (position > highest)
+            highest = position;
+
+        if (position < start)
+            below++;
+        else if (position > start)
+            above++;
+    }
+
+    if (below == 0)
+        return true;
+    if (above == 0)
+        return false;
+
+    if (sim->elevatorPolicy == ELEVATOR_NEARER)
+    {
+        // Heading for the closer extreme first means the long leg of the
+        // sweep is only travelled once.
+        return highest - start <= start - lowest;
+    }
+
+    return above >= below;
 }
 
 void printHeader(const char text[])
@@ -487,6 +1122,13 @@ void printIntList(const int list[], const int length)
     }
 }
 
+double monotonicSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
 int randint(const int min, const int max)
 {
     // Let it be distinctly understood that this is both non-random and
@@ -500,6 +1142,18 @@ int min(const int a, const int b)
     return a < b ? a : b;
 }
 
+long envLong(const char *name, const long fallback)
+{
+    const char *input = getenv(name);
+    return input != NULL ? atol(input) : fallback;
+}
+
+double envDouble(const char *name, const double fallback)
+{
+    const char *input = getenv(name);
+    return input != NULL ? atof(input) : fallback;
+}
+
 void *_safe_malloc(const size_t size, const char *file, const int line)
 {
     void *_ptr = malloc(size);
@@ -0,0 +1,135 @@
+/**
+ * On-disk memoisation of scheduler results
+ *
+ * @file memo.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "statcache.h"
+#include "memo.h"
+
+#define MEMO_PATH_SIZE 4096
+
+static uint64_t configurationKey(const Simulation *sim, const int scheduler);
+static bool entryPath(char path[], const ResultCache *cache,
+                      const uint64_t trace, const Simulation *sim,
+                      const int scheduler);
+
+bool resultCacheInit(ResultCache *cache)
+{
+    *cache = (ResultCache){.directory = getenv("D_RESULT_CACHE")};
+
+    if (cache->directory == NULL || cache->directory[0] == '\0')
+    {
+        cache->directory = NULL;
+        return false;
+    }
+
+    // An existing directory is fine; anything else shows up on first store.
+    mkdir(cache->directory, 0777);
+
+    return true;
+}
+
+bool resultCacheLoad(ResultCache *cache, const uint64_t trace,
+                     const Simulation *sim, const int scheduler,
+                     MemoResult *result)
+{
+    char path[MEMO_PATH_SIZE];
+    FILE *file = NULL;
+
+    if (entryPath(path, cache, trace, sim, scheduler))
+        file = fopen(path, "r");
+
+    bool hit = file != NULL &&
+               fscanf(file, "%d %d %ld %d", &result->state.start,
+                      &result->state.tally, &result->state.distance,
+                      &result->reversals) == 4;
+
+    for (int i = 0; hit && i < DISTANCE_BUCKETS; i++)
+        hit = fscanf(file, "%ld", &result->state.buckets[i]) == 1;
+
+    if (file != NULL)
+        fclose(file);
+
+    return hit;
+}
+
+void resultCacheCount(ResultCache *cache, const bool used, const int count)
+{
+    // Workers share one cache.
+    __atomic_fetch_add(used ? &cache->hits : &cache->misses, count,
+                       __ATOMIC_RELAXED);
+}
+
+void resultCacheStore(const ResultCache *cache, const uint64_t trace,
+                      const Simulation *sim, const int scheduler,
+                      const MemoResult *result)
+{
+    char path[MEMO_PATH_SIZE];
+    char temporary[MEMO_PATH_SIZE + 32];
+
+    if (!entryPath(path, cache, trace, sim, scheduler))
+        return;
+
+    // Written aside and renamed into place, so a reader never sees half an
+    // entry even when two workers store the same one.
+    snprintf(temporary, sizeof(temporary), "%s.%lx.tmp", path,
+             (unsigned long)pthread_self());
+
+    FILE *file = fopen(temporary, "w");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "Could not write result cache entry: %s\n", path);
+        return;
+    }
+
+    fprintf(file, "%d %d %ld %d", result->state.start, result->state.tally,
+            result->state.distance, result->reversals);
+
+    for (int i = 0; i < DISTANCE_BUCKETS; i++)
+        fprintf(file, " %ld", result->state.buckets[i]);
+
+    fprintf(file, "\n");
+
+    if (fclose(file) != 0 || rename(temporary, path) != 0)
+        remove(temporary);
+}
+
+static uint64_t configurationKey(const Simulation *sim, const int scheduler)
+{
+    // Everything that can change a run besides the trace itself
+    char configuration[256];
+    int length = snprintf(
+        configuration, sizeof(configuration),
+        "version=%d scheduler=%s start=%d chunk=%d elevator=%d,%d",
+        MEMO_VERSION, schedulers[scheduler].key, sim->states[scheduler].start,
+        D_CHUNK_SIZE, sim->elevatorPolicy, sim->elevatorUp);
+
+    return hashBytes(configuration, length, HASH_SEED);
+}
+
+static bool entryPath(char path[], const ResultCache *cache,
+                      const uint64_t trace, const Simulation *sim,
+                      const int scheduler)
+{
+    // MEMO_VERSION can't see a plugin change, so plugins always rerun.
+    if (scheduler >= BUILTIN_SCHEDULERS)
+        return false;
+
+    int length =
+        snprintf(path, MEMO_PATH_SIZE, "%s/%016" PRIx64 "-%016" PRIx64,
+                 cache->directory, trace, configurationKey(sim, scheduler));
+
+    return length < MEMO_PATH_SIZE;
+}
@@ -0,0 +1,48 @@
+/**
+ * On-disk memoisation of scheduler results
+ *
+ * A scheduler's result on a trace depends only on the trace's content and
+ * the configuration it ran under, so parameter sweeps that revisit the
+ * same combinations can read the result back rather than rerun it. Each
+ * entry is a small file in the D_RESULT_CACHE directory, named after a
+ * hash of the trace and a hash of the scheduler and its configuration.
+ *
+ * @file memo.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stdint.h>
+
+#include "dass.h"
+
+// Bump when a change to any scheduler alters its results, or the entries
+// change shape.
+#define MEMO_VERSION 2
+
+typedef struct ResultCache
+{
+    const char *directory;
+    long hits;
+    long misses;
+} ResultCache;
+
+typedef struct MemoResult
+{
+    SchedulerState state;
+    int reversals;
+} MemoResult;
+
+bool resultCacheInit(ResultCache *cache);
+bool resultCacheLoad(ResultCache *cache, const uint64_t trace,
+                     const Simulation *sim, const int scheduler,
+                     MemoResult *result);
+void resultCacheCount(ResultCache *cache, const bool used, const int count);
+void resultCacheStore(const ResultCache *cache, const uint64_t trace,
+                      const Simulation *sim, const int scheduler,
+                      const MemoResult *result);
+
+#endif
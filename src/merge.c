@@ -0,0 +1,171 @@
+/**
+ * Timestamp-ordered merging of several traces
+ *
+ * Each input is read lazily, one request at a time, and a tournament tree
+ * of losers picks whichever stream has the earliest pending request. The
+ * winner goes straight into the simulation tagged with its stream, so
+ * only one request per stream is ever held in memory. Requests with equal
+ * timestamps are taken in the order the streams were given.
+ *
+ * @file merge.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "blkimport.h"
+#include "writer.h"
+#include "merge.h"
+
+// Stands in for a stream that beats everything while the tree is built
+#define EARLIEST -1
+
+typedef struct Merge
+{
+    int count;
+    BlkReader *readers;
+    Request *heads;
+    bool *live;
+    int *tree;
+} Merge;
+
+static bool beats(const Merge *merge, const int a, const int b);
+static void replay(Merge *merge, int stream);
+
+bool mergeTraces(char *paths[], const int count)
+{
+    Merge merge = {
+        .count = count,
+        .readers = safe_malloc(sizeof(BlkReader) * count),
+        .heads = safe_malloc(sizeof(Request) * count),
+        .live = safe_malloc(sizeof(bool) * count),
+        .tree = safe_malloc(sizeof(int) * count),
+    };
+
+    FILE **files = safe_malloc(sizeof(FILE *) * count);
+    long *taken = safe_malloc(sizeof(long) * count);
+    bool ok = true;
+
+    for (int i = 0; i < count; i++)
+    {
+        files[i] = fopen(paths[i], "rb");
+        taken[i] = 0;
+
+        if (files[i] == NULL)
+        {
+            fprintf(stderr, "Could not open file: %s\n", paths[i]);
+            ok = false;
+        }
+        else if (!blkReaderOpen(&merge.readers[i], files[i]))
+        {
+            fclose(files[i]);
+            files[i] = NULL;
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        Simulation sim;
+        simulationInit(&sim);
+        writerStart(&sim);
+
+        // Prime every stream, then settle the tree one leaf at a time.
+        for (int i = 0; i < count; i++)
+        {
+            merge.live[i] = blkReaderNext(&merge.readers[i], &merge.heads[i]);
+            merge.heads[i].tenant = i;
+            merge.tree[i] = EARLIEST;
+        }
+
+        for (int i = count - 1; i >= 0; i--)
+            replay(&merge, i);
+
+        for (;;)
+        {
+            int winner = merge.tree[0];
+
+            if (!merge.live[winner])
+                break;
+
+            Request *request = &merge.heads[winner];
+            taken[request->tenant]++;
+            simulationFeed(&sim, request->cylinder);
+
+            merge.live[winner] =
+                blkReaderNext(&merge.readers[winner], &merge.heads[winner]);
+            merge.heads[winner].tenant = winner;
+            replay(&merge, winner);
+        }
+
+        simulationFinish(&sim);
+
+        printHeader("Requests per stream");
+        for (int i = 0; i < count; i++)
+            printf("%s: %ld\n", paths[i], taken[i]);
+        printf("\n");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (files[i] != NULL)
+        {
+            // A stream cut short by a bad record fails the merge.
+            if (merge.readers[i].failed)
+                ok = false;
+
+            blkReaderClose(&merge.readers[i]);
+            fclose(files[i]);
+        }
+    }
+
+    free(taken);
+    free(files);
+    free(merge.tree);
+    free(merge.live);
+    free(merge.heads);
+    free(merge.readers);
+
+    return ok;
+}
+
+static bool beats(const Merge *merge, const int a, const int b)
+{
+    if (a == EARLIEST)
+        return true;
+    if (b == EARLIEST)
+        return false;
+
+    // Exhausted streams lose to everything.
+    if (!merge->live[a] || !merge->live[b])
+        return merge->live[a];
+
+    double timeA = merge->heads[a].arrival;
+    double timeB = merge->heads[b].arrival;
+
+    if (timeA != timeB)
+        return timeA < timeB;
+
+    return a < b;
+}
+
+static void replay(Merge *merge, int stream)
+{
+    // Walk from the stream's leaf to the root. Each node keeps the loser
+    // of its match and the winner carries on upwards.
+    for (int node = (stream + merge->count) / 2; node > 0; node /= 2)
+    {
+        if (beats(merge, merge->tree[node], stream))
+        {
+            int loser = stream;
+            stream = merge->tree[node];
+            merge->tree[node] = loser;
+        }
+    }
+
+    merge->tree[0] = stream;
+}
@@ -0,0 +1,16 @@
+/**
+ * Timestamp-ordered merging of several traces
+ *
+ * @file merge.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <stdbool.h>
+
+bool mergeTraces(char *paths[], const int count);
+
+#endif
@@ -0,0 +1,539 @@
+/**
+ * Scheduling oracle
+ *
+ * @file oracle.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "dass.h"
+#include "oracle.h"
+
+// Replies waiting on a slow reader before its requests are left unread
+#define OUTPUT_BACKLOG (1 << 20)
+
+#define BUFFER_SIZE 65536
+
+typedef struct Connection
+{
+    int fd;
+    Simulation sim;
+
+    // Room for exactly one request of the largest allowed batch
+    int limit;
+    char *input;
+    size_t inputLength;
+    size_t inputCapacity;
+
+    char *output;
+    size_t outputLength;
+    size_t outputCapacity;
+
+    // Scratch for the batch being scheduled, kept between requests
+    int *seeks;
+
+    // What epoll is watching for, and why it may stop watching
+    uint32_t events;
+    bool finished;
+    bool closing;
+} Connection;
+
+static volatile sig_atomic_t stopping;
+
+static void stop(int signal);
+static int listenOn(const char *path);
+static Connection *openConnection(const int fd, const int limit);
+static void closeConnection(const int epoll, Connection *connection);
+static bool readRequests(Connection *connection);
+static bool serve(Connection *connection);
+static void watch(const int epoll, Connection *connection);
+static void answer(Connection *connection);
+static size_t answerOne(Connection *connection, const char *message,
+                        const size_t length);
+static void reply(Connection *connection, const OracleResponse *response,
+                  const int order[]);
+static bool writeReplies(Connection *connection);
+static void reserve(char **buffer, size_t *capacity, const size_t needed);
+
+bool serveOracle(const char *path)
+{
+    long limit = envLong("D_ORACLE_MAX", ORACLE_MAX_REQUESTS);
+
+    if (limit <= 0 || limit > ORACLE_LIMIT_MAX)
+    {
+        fprintf(stderr, "D_ORACLE_MAX must be between 1 and %d\n",
+                ORACLE_LIMIT_MAX);
+        return false;
+    }
+
+    int listener = listenOn(path);
+
+    if (listener < 0)
+        return false;
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+
+    struct sigaction action = {.sa_handler = stop};
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "Listening on %s\n", path);
+
+    struct epoll_event events[ORACLE_EVENTS];
+
+    while (!stopping)
+    {
+        int ready = epoll_wait(epoll, events, ORACLE_EVENTS, -1);
+
+        for (int i = 0; i < ready; i++)
+        {
+            Connection *connection = events[i].data.ptr;
+
+            if (connection == NULL)
+            {
+                int fd;
+
+                while ((fd = accept4(listener, NULL, NULL,
+                                     SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    connection = openConnection(fd, limit);
+                    event = (struct epoll_event){.events = connection->events,
+                                                 .data.ptr = connection};
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+                }
+
+                continue;
+            }
+
+            bool ok = true;
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                ok = readRequests(connection);
+
+            // Once the replies are out, a client that has stopped sending
+            // can't complete another request.
+            if (!ok || !serve(connection) ||
+                (connection->outputLength == 0 &&
+                 (connection->finished || connection->closing)))
+            {
+                closeConnection(epoll, connection);
+            }
+            else
+            {
+                watch(epoll, connection);
+            }
+        }
+    }
+
+    // Open connections are simply dropped along with the process.
+    close(epoll);
+    close(listener);
+    unlink(path);
+
+    return true;
+}
+
+bool askOracle(const char *path, const char *scheduler, const int head,
+               const int cylinders[], const int count)
+{
+    int index = -1;
+
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        if (streq(scheduler, schedulers[i].key))
+            index = i;
+    }
+
+    if (index < 0)
+    {
+        fprintf(stderr, "Unknown scheduler: %s\n", scheduler);
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    if (fd < 0 ||
+        connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        fprintf(stderr, "Could not connect to %s: %s\n", path,
+                strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    OracleRequest request = {
+        .count = count,
+        .scheduler = index,
+        .head = head,
+    };
+
+    OracleResponse response;
+    int *order = safe_malloc(sizeof(int) * (count > 0 ? count : 1));
+
+    bool ok = write(fd, &request, sizeof(request)) == sizeof(request) &&
+              write(fd, cylinders, sizeof(int) * count) ==
+                  (ssize_t)(sizeof(int) * count) &&
+              recv(fd, &response, sizeof(response), MSG_WAITALL) ==
+                  sizeof(response);
+
+    if (ok && response.status == ORACLE_OK)
+    {
+        ok = response.count <= (uint32_t)count &&
+             recv(fd, order, sizeof(int) * response.count, MSG_WAITALL) ==
+             (ssize_t)(sizeof(int) * response.count);
+    }
+
+    if (ok && response.status == ORACLE_OK)
+    {
+        printHeader(schedulers[index].title);
+        printf("Starting position: %d\n", head);
+        printf("Total distance: %ld\n", (long)response.distance);
+        printf("Effective seek count: %u\n", response.tally);
+        printf("Final position: %d\n", response.head);
+        printf("\n");
+        printIntList(order, response.count);
+    }
+    else if (ok)
+    {
+        fprintf(stderr, "The oracle refused the request (status %u).\n",
+                response.status);
+        ok = false;
+    }
+    else
+    {
+        fprintf(stderr, "Lost the connection to %s\n", path);
+    }
+
+    free(order);
+    close(fd);
+
+    return ok;
+}
+
+static void stop(int signal)
+{
+    (void)signal;
+    stopping = 1;
+}
+
+static int listenOn(const char *path)
+{
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+
+    strcpy(address.sun_path, path);
+
+    // A socket left behind by an earlier run would block the bind, but
+    // anything else at the path is somebody's file.
+    struct stat info;
+
+    if (lstat(path, &info) == 0)
+    {
+        if (!S_ISSOCK(info.st_mode))
+        {
+            fprintf(stderr, "Not a socket: %s\n", path);
+            return -1;
+        }
+
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0 ||
+        bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(fd, ORACLE_BACKLOG) != 0)
+    {
+        fprintf(stderr, "Could not listen on %s: %s\n", path,
+                strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static Connection *openConnection(const int fd, const int limit)
+{
+    Connection *connection = safe_malloc(sizeof(Connection));
+    *connection = (Connection){
+        .fd = fd,
+        .limit = limit,
+        .inputCapacity = sizeof(OracleRequest) + sizeof(int32_t) * limit,
+        .events = EPOLLIN,
+    };
+
+    simulationInit(&connection->sim);
+    connection->sim.quiet = true;
+
+    connection->input = safe_malloc(connection->inputCapacity);
+    connection->seeks = safe_malloc(sizeof(int) * limit);
+
+    return connection;
+}
+
+static void closeConnection(const int epoll, Connection *connection)
+{
+    epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+
+    simulationFree(&connection->sim);
+    free(connection->input);
+    free(connection->output);
+    free(connection->seeks);
+    free(connection);
+}
+
+static bool readRequests(Connection *connection)
+{
+    // Leave a slow reader's requests in the socket until it catches up,
+    // and never hold more than one whole request unanswered.
+    while (connection->outputLength < OUTPUT_BACKLOG &&
+           connection->inputLength < connection->inputCapacity)
+    {
+        ssize_t got = read(connection->fd,
+                           connection->input + connection->inputLength,
+                           connection->inputCapacity - connection->inputLength);
+
+        if (got > 0)
+        {
+            connection->inputLength += got;
+        }
+        else if (got == 0)
+        {
+            connection->finished = true;
+            return true;
+        }
+        else
+        {
+            return errno == EAGAIN || errno == EINTR;
+        }
+    }
+
+    return true;
+}
+
+static bool serve(Connection *connection)
+{
+    // Answer and write in turns, since requests already read in won't
+    // bring another event once the backlog clears.
+    for (;;)
+    {
+        size_t unanswered = connection->inputLength;
+
+        answer(connection);
+
+        if (!writeReplies(connection))
+            return false;
+
+        if (connection->inputLength == unanswered ||
+            connection->outputLength >= OUTPUT_BACKLOG)
+        {
+            return true;
+        }
+    }
+}
+
+static void watch(const int epoll, Connection *connection)
+{
+    // Only ask for what can be acted on: more requests while there's room
+    // for them and their replies, and room to write while replies wait.
+    uint32_t events = 0;
+
+    if (!connection->finished && !connection->closing &&
+        connection->outputLength < OUTPUT_BACKLOG &&
+        connection->inputLength < connection->inputCapacity)
+    {
+        events |= EPOLLIN;
+    }
+
+    if (connection->outputLength > 0)
+        events |= EPOLLOUT;
+
+    if (events != connection->events)
+    {
+        struct epoll_event event = {.events = events, .data.ptr = connection};
+        epoll_ctl(epoll, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+static void answer(Connection *connection)
+{
+    size_t done = 0;
+
+    while (!connection->closing && connection->outputLength < OUTPUT_BACKLOG)
+    {
+        size_t used = answerOne(connection, connection->input + done,
+                                connection->inputLength - done);
+        if (used == 0)
+            break;
+
+        done += used;
+    }
+
+    connection->inputLength -= done;
+    memmove(connection->input, connection->input + done,
+            connection->inputLength);
+}
+
+static size_t answerOne(Connection *connection, const char *message,
+                        const size_t length)
+{
+    OracleRequest request;
+    OracleResponse response = {.status = ORACLE_OK};
+
+    if (length < sizeof(request))
+        return 0;
+
+    memcpy(&request, message, sizeof(request));
+
+    // Too big to wait for; the rest of the stream can't be trusted.
+    if (request.count > (uint32_t)connection->limit)
+    {
+        response.status = ORACLE_TOO_MANY;
+        reply(connection, &response, NULL);
+        connection->closing = true;
+        return length;
+    }
+
+    size_t size = sizeof(request) + sizeof(int32_t) * request.count;
+
+    if (length < size)
+        return 0;
+
+    int *seeks = connection->seeks;
+    memcpy(seeks, message + sizeof(request), sizeof(int32_t) * request.count);
+
+    for (uint32_t i = 0; i < request.count; i++)
+    {
+        if (seeks[i] < D_SIZE_MIN || seeks[i] > D_SIZE_MAX)
+            response.status = ORACLE_OUT_OF_RANGE;
+    }
+
+    if (request.head != ORACLE_KEEP_HEAD &&
+        (request.head < D_SIZE_MIN || request.head > D_SIZE_MAX))
+    {
+        response.status = ORACLE_OUT_OF_RANGE;
+    }
+
+    if (request.scheduler >= (uint32_t)schedulerCount)
+        response.status = ORACLE_UNKNOWN_SCHEDULER;
+
+    if (response.status != ORACLE_OK)
+    {
+        reply(connection, &response, NULL);
+        return size;
+    }
+
+    Simulation *sim = &connection->sim;
+
+    if (request.flags & ORACLE_RESET)
+    {
+        simulationFree(sim);
+        simulationInit(sim);
+        sim->quiet = true;
+    }
+
+    SchedulerState *state = &sim->states[request.scheduler];
+    SchedulerState before = *state;
+
+    if (request.head != ORACLE_KEEP_HEAD)
+        state->start = request.head;
+
+    SeekList list = {seeks, request.count};
+    schedulers[request.scheduler].schedule(sim, state, &list);
+
+    response.count = request.count;
+    response.head = state->start;
+    response.tally = state->tally - before.tally;
+    response.distance = state->distance - before.distance;
+
+    reply(connection, &response, seeks);
+
+    return size;
+}
+
+static void reply(Connection *connection, const OracleResponse *response,
+                  const int order[])
+{
+    size_t orderSize = order != NULL ? sizeof(int32_t) * response->count : 0;
+
+    reserve(&connection->output, &connection->outputCapacity,
+            connection->outputLength + sizeof(*response) + orderSize);
+
+    memcpy(connection->output + connection->outputLength, response,
+           sizeof(*response));
+    connection->outputLength += sizeof(*response);
+
+    if (orderSize > 0)
+    {
+        memcpy(connection->output + connection->outputLength, order,
+               orderSize);
+        connection->outputLength += orderSize;
+    }
+}
+
+static bool writeReplies(Connection *connection)
+{
+    size_t done = 0;
+
+    while (done < connection->outputLength)
+    {
+        ssize_t wrote = write(connection->fd, connection->output + done,
+                              connection->outputLength - done);
+
+        if (wrote > 0)
+            done += wrote;
+        else if (wrote < 0 && errno == EINTR)
+            continue;
+        else if (wrote < 0 && errno == EAGAIN)
+            break;
+        else
+            return false;
+    }
+
+    connection->outputLength -= done;
+    memmove(connection->output, connection->output + done,
+            connection->outputLength);
+
+    return true;
+}
+
+static void reserve(char **buffer, size_t *capacity, const size_t needed)
+{
+    if (needed <= *capacity)
+        return;
+
+    size_t size = *capacity > 0 ? *capacity : BUFFER_SIZE;
+    while (size < needed)
+        size *= 2;
+
+    *buffer = safe_realloc(*buffer, size);
+    *capacity = size;
+}
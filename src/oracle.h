@@ -0,0 +1,70 @@
+/**
+ * Scheduling oracle
+ *
+ * A daemon on a Unix domain socket that answers "in what order would this
+ * scheduler serve these requests from here?" for other local tools. Every
+ * connection keeps its own simulation, so heads and the elevator's sweep
+ * carry on from one batch to the next until the client resets them.
+ *
+ * Messages are in host byte order. A request is an OracleRequest followed
+ * by `count` int32 cylinders; the reply is an OracleResponse followed, on
+ * success, by the same cylinders in the order they would be served. Any
+ * number of requests may be in flight on one connection; replies come
+ * back in order.
+ *
+ * @file oracle.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef ORACLE_H
+#define ORACLE_H
+
+#include <stdint.h>
+
+#include "dass.h"
+
+// Largest batch served (D_ORACLE_MAX); the schedulers are quadratic.
+#define ORACLE_MAX_REQUESTS 4096
+// Upper bound on D_ORACLE_MAX, which sizes every connection's buffers
+#define ORACLE_LIMIT_MAX (1 << 20)
+
+#define ORACLE_BACKLOG 64
+#define ORACLE_EVENTS 64
+
+// Head value meaning "wherever the last batch left it"
+#define ORACLE_KEEP_HEAD -1
+
+// Request flags
+#define ORACLE_RESET 0x1
+
+typedef enum OracleStatus
+{
+    ORACLE_OK,
+    ORACLE_UNKNOWN_SCHEDULER,
+    ORACLE_TOO_MANY,
+    ORACLE_OUT_OF_RANGE
+} OracleStatus;
+
+typedef struct OracleRequest
+{
+    uint32_t count;
+    uint32_t scheduler;
+    int32_t head;
+    uint32_t flags;
+} OracleRequest;
+
+typedef struct OracleResponse
+{
+    uint32_t status;
+    uint32_t count;
+    int32_t head;
+    uint32_t tally;
+    int64_t distance;
+} OracleResponse;
+
+bool serveOracle(const char *path);
+bool askOracle(const char *path, const char *scheduler, const int head,
+               const int cylinders[], const int count);
+
+#endif
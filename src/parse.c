@@ -0,0 +1,377 @@
+/**
+ * Text trace parsing and validation
+ *
+ * @file parse.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "parse.h"
+#include "histogram.h"
+
+typedef struct ParseRange
+{
+    const char *begin;
+    const char *end;
+
+    int *seeks;
+    long length;
+    bool counting;
+    SeekHistogram *histogram;
+
+    Validation validation;
+} ParseRange;
+
+static const char *const invalidNames[INVALID_KINDS] = {
+    "out of range",
+    "non-numeric",
+    "overflow",
+};
+
+static void *parseRange(void *argument);
+static long countTokens(const ParseRange *range);
+static void recordInvalid(Validation *validation, const InvalidKind kind,
+                          const char *text, const char *end);
+static bool isSpace(const char c);
+
+void validationInit(Validation *validation)
+{
+    *validation = (Validation){
+        .exampleLimit = envLong("D_INVALID_EXAMPLES", INVALID_EXAMPLES),
+        .strict = getenv("D_STRICT") != NULL,
+    };
+
+    // Strict mode always keeps the offending entry for its message.
+    if (validation->exampleLimit < (validation->strict ? 1 : 0))
+        validation->exampleLimit = validation->strict ? 1 : 0;
+    if (validation->exampleLimit > INVALID_EXAMPLES_MAX)
+        validation->exampleLimit = INVALID_EXAMPLES_MAX;
+}
+
+void validationMerge(Validation *into, const Validation *from)
+{
+    // Line numbers in the later part carry on from the earlier one.
+    for (int i = 0; i < from->exampleCount &&
+                    into->exampleCount < into->exampleLimit;
+         i++)
+    {
+        InvalidExample example = from->examples[i];
+        example.line += into->lines;
+        into->examples[into->exampleCount++] = example;
+    }
+
+    for (int i = 0; i < INVALID_KINDS; i++)
+        into->counts[i] += from->counts[i];
+
+    into->lines += from->lines;
+    into->failed |= from->failed;
+}
+
+long validationInvalid(const Validation *validation)
+{
+    long invalid = 0;
+
+    for (int i = 0; i < INVALID_KINDS; i++)
+        invalid += validation->counts[i];
+
+    return invalid;
+}
+
+bool validationReport(const Validation *validation, const char *source)
+{
+    if (validation->failed)
+    {
+        const InvalidExample *example = &validation->examples[0];
+        fprintf(stderr, "%s:%ld: invalid seek (%s): %s\n", source,
+                example->line, invalidNames[example->kind], example->text);
+        return false;
+    }
+
+    long invalid = validationInvalid(validation);
+
+    if (invalid == 0)
+        return true;
+
+    // One summary, however corrupt the trace
+    fprintf(stderr, "\n%s: skipped %ld invalid seek%s (", source, invalid,
+            invalid == 1 ? "" : "s");
+
+    for (int i = 0, shown = 0; i < INVALID_KINDS; i++)
+    {
+        if (validation->counts[i] > 0)
+        {
+            fprintf(stderr, "%s%ld %s", shown++ > 0 ? ", " : "",
+                    validation->counts[i], invalidNames[i]);
+        }
+    }
+
+    fprintf(stderr, ")\n");
+
+    for (int i = 0; i < validation->exampleCount; i++)
+    {
+        const InvalidExample *example = &validation->examples[i];
+        fprintf(stderr, "  line %ld: %s: %s\n", example->line,
+                invalidNames[example->kind], example->text);
+    }
+
+    if (invalid > validation->exampleCount)
+    {
+        fprintf(stderr, "  ... and %ld more\n",
+                invalid - validation->exampleCount);
+    }
+
+    fprintf(stderr, "\n");
+
+    return true;
+}
+
+long parseSeekText(const char *text, const char *end, int seeks[],
+                   Validation *validation)
+{
+    const char *p = text;
+    long length = 0;
+
+    for (;;)
+    {
+        for (; p < end && isSpace(*p); p++)
+        {
+            if (*p == '\n')
+                validation->lines++;
+        }
+
+        if (p == end)
+            break;
+
+        const char *token = p;
+
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+')
+            p++;
+
+        // Saturate rather than overflow; anything past an int is flagged
+        // either way.
+        const char *digits = p;
+        long seek = 0;
+
+        for (; p < end && '0' <= *p && *p <= '9'; p++)
+            seek = seek <= INT_MAX ? seek * 10 + (*p - '0') : seek;
+
+        InvalidKind kind;
+
+        if (p == digits || (p < end && !isSpace(*p)))
+        {
+            while (p < end && !isSpace(*p))
+                p++;
+            kind = INVALID_NUMBER;
+        }
+        else if (seek > INT_MAX)
+        {
+            kind = INVALID_OVERFLOW;
+        }
+        else
+        {
+            if (negative)
+                seek = -seek;
+
+            if (D_SIZE_MIN <= seek && seek <= D_SIZE_MAX)
+            {
+                seeks[length++] = seek;
+                continue;
+            }
+
+            kind = INVALID_RANGE;
+        }
+
+        recordInvalid(validation, kind, token, p);
+
+        if (validation->strict)
+        {
+            validation->failed = true;
+            break;
+        }
+    }
+
+    return length;
+}
+
+const char *wholeTokens(const char *text, const char *end)
+{
+    // Just past the last separator, so a token still being written waits
+    for (const char *p = end; p > text; p--)
+    {
+        if (isSpace(p[-1]))
+            return p;
+    }
+
+    return text;
+}
+
+bool parseSeekFile(const char *path, RequestTable *requests)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        fprintf(stderr, "Could not open file: %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    size_t size = info.st_size;
+
+    if (size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    const char *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (text == MAP_FAILED)
+    {
+        fprintf(stderr, "Could not map file: %s\n", path);
+        return false;
+    }
+
+    madvise((void *)text, size, MADV_SEQUENTIAL);
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = envLong("D_THREADS", online > 0 ? online : 1);
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)threads > size / (PARSE_PARALLEL_MIN / 4) + 1)
+        threads = size / (PARSE_PARALLEL_MIN / 4) + 1;
+
+    ParseRange *ranges = safe_malloc(sizeof(ParseRange) * threads);
+    pthread_t *workers = safe_malloc(sizeof(pthread_t) * threads);
+    const char *end = text + size;
+    const char *begin = text;
+
+    for (int i = 0; i < threads; i++)
+    {
+        // Move each cut forward to just past a newline.
+        const char *cut = i + 1 < threads ? text + size / threads * (i + 1)
+                                          : end;
+        if (cut < begin)
+            cut = begin;
+        while (cut < end && cut > text && cut[-1] != '\n')
+            cut++;
+
+        ranges[i] = (ParseRange){
+            .begin = begin,
+            .end = cut,
+            .counting = requests->histogram != NULL,
+        };
+        validationInit(&ranges[i].validation);
+        begin = cut;
+    }
+
+    for (int i = 0; i < threads; i++)
+        pthread_create(&workers[i], NULL, parseRange, &ranges[i]);
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+
+    // Join the blocks in order. In strict mode nothing after the first
+    // failure counts.
+    Validation validation;
+    validationInit(&validation);
+
+    for (int i = 0; i < threads; i++)
+    {
+        ParseRange *range = &ranges[i];
+
+        if (!validation.failed)
+        {
+            validationMerge(&validation, &range->validation);
+            requestTableAppendCounted(requests, range->seeks, range->length,
+                                      range->histogram);
+        }
+
+        free(range->seeks);
+        free(range->histogram);
+    }
+
+    munmap((void *)text, size);
+    free(ranges);
+    free(workers);
+
+    return validationReport(&validation, path);
+}
+
+static void *parseRange(void *argument)
+{
+    ParseRange *range = argument;
+
+    range->seeks = safe_malloc(sizeof(int) * (countTokens(range) + 1));
+    range->length = parseSeekText(range->begin, range->end, range->seeks,
+                                  &range->validation);
+
+    if (range->counting)
+    {
+        range->histogram = histogramCreate();
+        histogramAddMany(range->histogram, range->seeks, range->length);
+    }
+
+    return NULL;
+}
+
+static long countTokens(const ParseRange *range)
+{
+    // Each seek, valid or not, is one run of non-space characters, so this
+    // sizes the range exactly rather than guessing from its length.
+    long count = 0;
+    bool inToken = false;
+
+    for (const char *p = range->begin; p < range->end; p++)
+    {
+        bool space = isSpace(*p);
+
+        if (!space && !inToken)
+            count++;
+        inToken = !space;
+    }
+
+    return count;
+}
+
+static void recordInvalid(Validation *validation, const InvalidKind kind,
+                          const char *text, const char *end)
+{
+    validation->counts[kind]++;
+
+    if (validation->exampleCount >= validation->exampleLimit)
+        return;
+
+    InvalidExample *example =
+        &validation->examples[validation->exampleCount++];
+    size_t length = end - text;
+
+    if (length >= INVALID_TEXT_SIZE)
+        length = INVALID_TEXT_SIZE - 1;
+
+    example->kind = kind;
+    example->line = validation->lines + 1;
+    memcpy(example->text, text, length);
+    example->text[length] = '\0';
+}
+
+static bool isSpace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+           c == '\f';
+}
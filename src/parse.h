@@ -0,0 +1,72 @@
+/**
+ * Text trace parsing and validation
+ *
+ * Seeks are whitespace-separated integers. Entries that can't be used are
+ * skipped and counted by category rather than reported one by one; the
+ * first few are kept, with their line numbers, for a single summary at
+ * the end. In strict mode (D_STRICT) the first invalid entry is fatal.
+ *
+ * Large traces are mapped into memory and cut into one range per thread,
+ * each beginning just after a newline, so no seek straddles two ranges.
+ * Every range is parsed into its own block, and the blocks are joined in
+ * file order, so the result matches a single-threaded read.
+ *
+ * @file parse.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef PARSE_H
+#define PARSE_H
+
+#include "dass.h"
+#include "requests.h"
+
+// Smaller traces are not worth the threads.
+#define PARSE_PARALLEL_MIN (1 << 20)
+
+// Invalid entries shown in full (D_INVALID_EXAMPLES, up to the maximum)
+#define INVALID_EXAMPLES 5
+#define INVALID_EXAMPLES_MAX 64
+#define INVALID_TEXT_SIZE 24
+
+typedef enum InvalidKind
+{
+    INVALID_RANGE,
+    INVALID_NUMBER,
+    INVALID_OVERFLOW,
+    INVALID_KINDS
+} InvalidKind;
+
+typedef struct InvalidExample
+{
+    InvalidKind kind;
+    long line;
+    char text[INVALID_TEXT_SIZE];
+} InvalidExample;
+
+typedef struct Validation
+{
+    long counts[INVALID_KINDS];
+    InvalidExample examples[INVALID_EXAMPLES_MAX];
+    int exampleCount;
+    int exampleLimit;
+
+    // Newlines seen so far
+    long lines;
+
+    bool strict;
+    bool failed;
+} Validation;
+
+void validationInit(Validation *validation);
+void validationMerge(Validation *into, const Validation *from);
+long validationInvalid(const Validation *validation);
+bool validationReport(const Validation *validation, const char *source);
+
+long parseSeekText(const char *text, const char *end, int seeks[],
+                   Validation *validation);
+const char *wholeTokens(const char *text, const char *end);
+bool parseSeekFile(const char *path, RequestTable *requests);
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * Schedule permutation checks
+ *
+ * @file permcheck.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dass.h"
+#include "permcheck.h"
+
+// Per-thread, since batch workers and the pipeline schedule concurrently
+typedef struct Scratch
+{
+    uint32_t counts[D_SIZE_MAX - D_SIZE_MIN + 1];
+    int *saved;
+    int savedLength;
+    int capacity;
+} Scratch;
+
+static pthread_key_t scratchKey;
+static pthread_once_t scratchOnce = PTHREAD_ONCE_INIT;
+
+static Scratch *scratch(void);
+static void createKey(void);
+static void freeScratch(void *pointer);
+
+void permutationSave(const int seeks[], const int length)
+{
+    Scratch *s = scratch();
+
+    if (length > s->capacity)
+    {
+        s->saved = safe_realloc(s->saved, sizeof(int) * length);
+        s->capacity = length;
+    }
+
+    memcpy(s->saved, seeks, sizeof(int) * length);
+    s->savedLength = length;
+
+    for (int i = 0; i < length; i++)
+        s->counts[seeks[i] - D_SIZE_MIN]++;
+}
+
+bool permutationCheck(int seeks[], int *offender)
+{
+    Scratch *s = scratch();
+    bool ok = true;
+
+    // Each cylinder may come back only as often as it went in; with the
+    // length fixed, that leaves no room for anything to go missing.
+    for (int i = 0; ok && i < s->savedLength; i++)
+    {
+        int seek = seeks[i];
+
+        if (seek < D_SIZE_MIN || seek > D_SIZE_MAX ||
+            s->counts[seek - D_SIZE_MIN] == 0)
+        {
+            *offender = seek;
+            ok = false;
+        }
+        else
+        {
+            s->counts[seek - D_SIZE_MIN]--;
+        }
+    }
+
+    if (!ok)
+    {
+        // Leave the table clear and hand the next scheduler what this one
+        // was given.
+        for (int i = 0; i < s->savedLength; i++)
+            s->counts[s->saved[i] - D_SIZE_MIN] = 0;
+
+        memcpy(seeks, s->saved, sizeof(int) * s->savedLength);
+    }
+
+    return ok;
+}
+
+void permutationViolation(Simulation *sim, const int scheduler,
+                          const int offender)
+{
+    long reported = 0;
+    for (int i = 0; i < schedulerCount; i++)
+        reported += sim->scheduleViolations[i];
+
+    sim->scheduleViolations[scheduler]++;
+
+    if (reported < PERMUTATION_REPORTS)
+    {
+        fprintf(stderr,
+                "%s: schedule for chunk %ld is not a reordering of it "
+                "(%d doesn't belong)\n",
+                schedulers[scheduler].title, sim->schedulesChecked,
+                offender);
+    }
+    else if (reported == PERMUTATION_REPORTS)
+    {
+        fprintf(stderr, "Further invalid schedules will only be counted.\n");
+    }
+}
+
+void printScheduleChecks(const Simulation *sim)
+{
+    printHeader("Schedule checks");
+    printf("Chunks checked: %ld\n", sim->schedulesChecked);
+
+    for (int i = 0; i < schedulerCount; i++)
+    {
+        if (sim->scheduleViolations[i] > 0)
+        {
+            printf("%s: %ld invalid schedules (left out)\n",
+                   schedulers[i].title, sim->scheduleViolations[i]);
+        }
+    }
+}
+
+static Scratch *scratch(void)
+{
+    pthread_once(&scratchOnce, createKey);
+
+    Scratch *s = pthread_getspecific(scratchKey);
+
+    if (s == NULL)
+    {
+        s = safe_malloc(sizeof(Scratch));
+        memset(s, 0, sizeof(Scratch));
+        pthread_setspecific(scratchKey, s);
+    }
+
+    return s;
+}
+
+static void createKey(void)
+{
+    pthread_key_create(&scratchKey, freeScratch);
+}
+
+static void freeScratch(void *pointer)
+{
+    Scratch *s = pointer;
+
+    free(s->saved);
+    free(s);
+}
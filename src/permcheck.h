@@ -0,0 +1,30 @@
+/**
+ * Schedule permutation checks
+ *
+ * A scheduler may only reorder its chunk. With D_CHECK_SCHEDULES=1 every
+ * schedule is checked against the chunk it was given in linear time, by
+ * counting cylinders in a table covering the whole disk, so plugins and
+ * optimised engines can't quietly drop, duplicate or invent requests.
+ * A schedule that fails is undone, so it counts towards nothing but the
+ * violations.
+ *
+ * @file permcheck.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef PERMCHECK_H
+#define PERMCHECK_H
+
+#include "dass.h"
+
+// Violations described on stderr before only the counts are kept
+#define PERMUTATION_REPORTS 5
+
+void permutationSave(const int seeks[], const int length);
+bool permutationCheck(int seeks[], int *offender);
+void permutationViolation(Simulation *sim, const int scheduler,
+                          const int offender);
+void printScheduleChecks(const Simulation *sim);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Pipelined processing of a text trace
+ *
+ * @file pipeline.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dass.h"
+#include "parse.h"
+#include "spsc.h"
+#include "writer.h"
+#include "pipeline.h"
+
+typedef struct SeekBlock
+{
+    int *seeks;
+    int length;
+    int capacity;
+} SeekBlock;
+
+typedef struct Pipeline
+{
+    FILE *in;
+    bool readFailed;
+
+    SeekBlock blocks[PIPELINE_BLOCKS];
+
+    // Forward, stage to stage
+    SpscQueue parsed;
+    SpscQueue counted;
+
+    // Back to the reader
+    SpscQueue spareBlocks;
+
+    Validation validation;
+    Simulation sim;
+} Pipeline;
+
+// Marks the end of the stream.
+static SeekBlock endOfBlocks;
+
+static void *readStage(void *argument);
+static void *statsStage(void *argument);
+static void *scheduleStage(void *argument);
+
+bool runPipeline(FILE *in, const char *source)
+{
+    Pipeline *pipeline = safe_malloc(sizeof(Pipeline));
+    *pipeline = (Pipeline){.in = in};
+
+    spscInit(&pipeline->parsed, PIPELINE_BLOCKS);
+    spscInit(&pipeline->counted, PIPELINE_BLOCKS);
+    spscInit(&pipeline->spareBlocks, PIPELINE_BLOCKS);
+
+    for (int i = 0; i < PIPELINE_BLOCKS; i++)
+        spscPush(&pipeline->spareBlocks, &pipeline->blocks[i]);
+
+    validationInit(&pipeline->validation);
+    simulationInit(&pipeline->sim);
+
+    // The writer thread is the output stage.
+    writerStart(&pipeline->sim);
+
+    void *(*stages[])(void *) = {readStage, statsStage, scheduleStage};
+    const int stageCount = sizeof(stages) / sizeof(stages[0]);
+    pthread_t threads[stageCount];
+
+    for (int i = 0; i < stageCount; i++)
+        pthread_create(&threads[i], NULL, stages[i], pipeline);
+    for (int i = 0; i < stageCount; i++)
+        pthread_join(threads[i], NULL);
+
+    bool ok = validationReport(&pipeline->validation, source);
+
+    if (pipeline->readFailed)
+    {
+        fprintf(stderr, "Could not read: %s\n", source);
+        ok = false;
+    }
+
+    for (int i = 0; i < PIPELINE_BLOCKS; i++)
+        free(pipeline->blocks[i].seeks);
+
+    spscFree(&pipeline->parsed);
+    spscFree(&pipeline->counted);
+    spscFree(&pipeline->spareBlocks);
+    free(pipeline);
+
+    return ok;
+}
+
+static void *readStage(void *argument)
+{
+    Pipeline *pipeline = argument;
+
+    size_t capacity = PIPELINE_READ_SIZE;
+    char *text = safe_malloc(capacity);
+    size_t length = 0;
+    bool finished = false;
+
+    while (!finished && !pipeline->validation.failed)
+    {
+        if (length == capacity)
+        {
+            // One token bigger than the whole buffer
+            capacity *= 2;
+            text = safe_realloc(text, capacity);
+        }
+
+        size_t got = fread(text + length, 1, capacity - length, pipeline->in);
+        length += got;
+        finished = got == 0;
+
+        // A read error ends the stream too, but fails the run.
+        if (finished && ferror(pipeline->in))
+        {
+            pipeline->readFailed = true;
+            break;
+        }
+
+        // Only whole tokens are parsed; a partial one waits for the rest.
+        const char *end = finished ? text + length
+                                   : wholeTokens(text, text + length);
+
+        if (end == text && !finished)
+            continue;
+
+        SeekBlock *block = spscPop(&pipeline->spareBlocks);
+        int needed = (end - text) / 2 + 1;
+
+        if (block->capacity < needed)
+        {
+            block->capacity = needed;
+            block->seeks =
+                safe_realloc(block->seeks, sizeof(int) * block->capacity);
+        }
+
+        block->length =
+            parseSeekText(text, end, block->seeks, &pipeline->validation);
+        spscPush(&pipeline->parsed, block);
+
+        length -= end - text;
+        memmove(text, end, length);
+    }
+
+    free(text);
+    spscPush(&pipeline->parsed, &endOfBlocks);
+
+    return NULL;
+}
+
+static void *statsStage(void *argument)
+{
+    Pipeline *pipeline = argument;
+    SeekBlock *block;
+
+    // The whole-trace half of simulationFeed(); the scheduling half is
+    // the next stage's, and neither touches what the other keeps.
+    while ((block = spscPop(&pipeline->parsed)) != &endOfBlocks)
+    {
+        for (int i = 0; i < block->length; i++)
+            simulationCount(&pipeline->sim, block->seeks[i]);
+
+        spscPush(&pipeline->counted, block);
+    }
+
+    spscPush(&pipeline->counted, &endOfBlocks);
+
+    return NULL;
+}
+
+static void *scheduleStage(void *argument)
+{
+    Pipeline *pipeline = argument;
+    Simulation *sim = &pipeline->sim;
+    SeekBlock *block;
+
+    while ((block = spscPop(&pipeline->counted)) != &endOfBlocks)
+    {
+        for (int i = 0; i < block->length; i++)
+            simulationQueue(sim, block->seeks[i]);
+
+        spscPush(&pipeline->spareBlocks, block);
+    }
+
+    // The stats stage finished before passing on the end of the stream,
+    // so its totals are complete. A strict-mode failure or a read error
+    // gets none.
+    sim->quiet = pipeline->validation.failed || pipeline->readFailed;
+
+    simulationFinish(sim);
+
+    return NULL;
+}
@@ -0,0 +1,33 @@
+/**
+ * Pipelined processing of a text trace
+ *
+ * Reading, statistics, scheduling and printing each get a thread of their
+ * own, joined by bounded SPSC queues:
+ *
+ *   reader -> stats -> schedulers -> output (the asynchronous writer)
+ *
+ * Seeks travel in blocks and chunk results in records, both drawn from
+ * fixed pools and handed back once used, so a slow stage stalls the ones
+ * before it instead of letting memory grow.
+ *
+ * @file pipeline.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+
+#include "dass.h"
+
+// Raw input read per block
+#define PIPELINE_READ_SIZE 65536
+
+// Blocks in flight
+#define PIPELINE_BLOCKS 8
+
+bool runPipeline(FILE *in, const char *source);
+
+#endif
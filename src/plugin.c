@@ -0,0 +1,177 @@
+/**
+ * Scheduler plugin loading
+ *
+ * @file plugin.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlfcn.h>
+
+#include "dass.h"
+#include "plugin.h"
+
+// The scheduler table holds bare functions, so each plugin slot gets its
+// own to find its way back to the plugin.
+#define PLUGIN_SLOT(slot)                                                    \
+    static void schedulePlugin##slot(Simulation *sim, SchedulerState *state, \
+                                     SeekList *seeks)                        \
+    {                                                                        \
+        runPlugin(slot, sim, state, seeks);                                  \
+    }
+
+static const DassScheduler *plugins[PLUGIN_SCHEDULERS_MAX];
+
+static void runPlugin(const int slot, Simulation *sim, SchedulerState *state,
+                      SeekList *seeks);
+static bool checkPlugin(const DassPlugin *plugin, const char *path);
+static void registerPlugin(const DassScheduler *plugin);
+
+PLUGIN_SLOT(0)
+PLUGIN_SLOT(1)
+PLUGIN_SLOT(2)
+PLUGIN_SLOT(3)
+PLUGIN_SLOT(4)
+
+static void (*const slots[])(Simulation *, SchedulerState *, SeekList *) = {
+    schedulePlugin0, schedulePlugin1, schedulePlugin2,
+    schedulePlugin3, schedulePlugin4,
+};
+
+_Static_assert(sizeof(slots) / sizeof(slots[0]) == PLUGIN_SCHEDULERS_MAX,
+               "one slot function per plugin scheduler");
+
+bool loadPlugin(const char *path)
+{
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+    if (handle == NULL)
+    {
+        fprintf(stderr, "Could not load plugin: %s\n", dlerror());
+        return false;
+    }
+
+    // Plugins stay loaded until exit; their tables are used in place.
+    DassPluginEntry entry;
+    *(void **)&entry = dlsym(handle, DASS_PLUGIN_SYMBOL);
+
+    const DassPlugin *plugin = entry != NULL ? entry() : NULL;
+
+    if (plugin == NULL)
+    {
+        fprintf(stderr, "Not a scheduler plugin: %s\n", path);
+        dlclose(handle);
+        return false;
+    }
+
+    // All or nothing, so nothing is left pointing into an unloaded table
+    if (!checkPlugin(plugin, path))
+    {
+        dlclose(handle);
+        return false;
+    }
+
+    for (int i = 0; i < plugin->count; i++)
+        registerPlugin(&plugin->schedulers[i]);
+
+    return true;
+}
+
+void pluginStatesFree(Simulation *sim)
+{
+    for (int i = BUILTIN_SCHEDULERS; i < schedulerCount; i++)
+    {
+        const DassScheduler *plugin = plugins[i - BUILTIN_SCHEDULERS];
+
+        if (sim->pluginStates[i] != NULL)
+            plugin->destroy(sim->pluginStates[i]);
+        sim->pluginStates[i] = NULL;
+    }
+}
+
+static void runPlugin(const int slot, Simulation *sim, SchedulerState *state,
+                      SeekList *seeks)
+{
+    const DassScheduler *plugin = plugins[slot];
+    void **own = &sim->pluginStates[BUILTIN_SCHEDULERS + slot];
+
+    if (plugin->create != NULL && *own == NULL)
+    {
+        *own = plugin->create(plugin->context);
+
+        if (*own == NULL)
+        {
+            fprintf(stderr, "Scheduler \"%s\" could not start\n", plugin->key);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    plugin->schedule(plugin->create != NULL ? *own : plugin->context,
+                     state->start, seeks->list, seeks->length);
+
+    // Serving the plugin's order as given does the bookkeeping.
+    firstComeFirstServed(sim, state, seeks);
+}
+
+static bool checkPlugin(const DassPlugin *plugin, const char *path)
+{
+    if (plugin->abi != DASS_PLUGIN_ABI)
+    {
+        fprintf(stderr, "Plugin %s was built for ABI %u, not %d\n", path,
+                plugin->abi, DASS_PLUGIN_ABI);
+        return false;
+    }
+
+    if (plugin->count < 0 ||
+        schedulerCount + plugin->count > SCHEDULERS_MAX)
+    {
+        fprintf(stderr, "Plugin %s: no room for more than %d schedulers\n",
+                path, PLUGIN_SCHEDULERS_MAX);
+        return false;
+    }
+
+    for (int i = 0; i < plugin->count; i++)
+    {
+        const DassScheduler *scheduler = &plugin->schedulers[i];
+
+        if (scheduler->title == NULL || scheduler->key == NULL ||
+            scheduler->schedule == NULL ||
+            (scheduler->create == NULL) != (scheduler->destroy == NULL))
+        {
+            fprintf(stderr, "Incomplete scheduler in plugin %s\n", path);
+            return false;
+        }
+
+        // Against those already loaded and the rest of this plugin
+        for (int j = 0; j < schedulerCount + i; j++)
+        {
+            const char *key = j < schedulerCount
+                                  ? schedulers[j].key
+                                  : plugin->schedulers[j - schedulerCount].key;
+
+            if (streq(key, scheduler->key))
+            {
+                fprintf(stderr,
+                        "Plugin %s: scheduler \"%s\" already exists\n",
+                        path, scheduler->key);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void registerPlugin(const DassScheduler *plugin)
+{
+    int slot = schedulerCount - BUILTIN_SCHEDULERS;
+
+    plugins[slot] = plugin;
+    schedulers[schedulerCount++] = (Scheduler){
+        .title = plugin->title,
+        .key = plugin->key,
+        .schedule = slots[slot],
+    };
+}
@@ -0,0 +1,24 @@
+/**
+ * Scheduler plugin loading
+ *
+ * Schedulers from plugins are registered after the built-ins and run
+ * wherever the built-ins do: chunking, output, statistics, replay, batch
+ * reports, the oracle and the benchmarks.
+ *
+ * @file plugin.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include "dass.h"
+#include "dassplugin.h"
+
+#define PLUGIN_SCHEDULERS_MAX (SCHEDULERS_MAX - BUILTIN_SCHEDULERS)
+
+bool loadPlugin(const char *path);
+void pluginStatesFree(Simulation *sim);
+
+#endif
@@ -0,0 +1,491 @@
+/**
+ * Replay of scheduled seeks against real storage
+ *
+ * Every scheduler orders the trace exactly as it would in a simulation run,
+ * after which its order is issued as reads against a file or block device.
+ * Cylinders are spread evenly across the target. Reads go through io_uring
+ * so that several can be in flight at once, or through plain pread() when
+ * io_uring is unavailable.
+ *
+ * @file replay.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/io_uring.h>
+
+#include "dass.h"
+#include "replay.h"
+
+#define REPLAY_BLOCK_SIZE 4096
+#define CYLINDERS (D_SIZE_MAX - D_SIZE_MIN + 1)
+
+typedef struct Ring
+{
+    int fd;
+    unsigned int entries;
+
+    unsigned int *sqHead;
+    unsigned int *sqTail;
+    unsigned int *sqMask;
+    unsigned int *sqArray;
+    struct io_uring_sqe *sqes;
+
+    unsigned int *cqHead;
+    unsigned int *cqTail;
+    unsigned int *cqMask;
+    struct io_uring_cqe *cqes;
+
+    void *sqRing;
+    void *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+} Ring;
+
+typedef struct Target
+{
+    int fd;
+    long long size;
+    long long stride;
+    int blockSize;
+    bool direct;
+} Target;
+
+typedef struct ReplayStats
+{
+    double elapsed;
+    double *latencies;
+    int count;
+    int errors;
+} ReplayStats;
+
+static bool openTarget(const char *path, Target *target);
+static long long offsetOf(const Target *target, const int cylinder);
+static void scheduleAll(SeekList seeks, const int scheduler, int order[]);
+
+static bool ringInit(Ring *ring, const unsigned int entries);
+static void ringFree(Ring *ring);
+static bool replayRing(Ring *ring, const Target *target, const int order[],
+                       const int length, const int depth,
+                       ReplayStats *stats);
+static void replaySync(const Target *target, const int order[],
+                       const int length, ReplayStats *stats);
+
+static void printReplayStats(const char title[], const Target *target,
+                             ReplayStats *stats);
+static int compareDoubles(const void *a, const void *b);
+
+bool replay(SeekList seeks, const char *path, const int depth)
+{
+    Target target;
+    if (!openTarget(path, &target))
+        return false;
+
+    Ring ring;
+    bool useRing = !envLong("D_REPLAY_SYNC", 0) && ringInit(&ring, depth);
+
+    printHeader("Replay");
+    printf(
+        "Target: %s\n"
+        "Target size: %lld bytes\n"
+        "Read size: %d bytes\n"
+        "Queue depth: %d\n"
+        "Engine: %s\n"
+        "Direct I/O: %s\n",
+        path, target.size, target.blockSize, useRing ? depth : 1,
+        useRing ? "io_uring" : "synchronous pread",
+        target.direct ? "yes" : "no");
+
+    int slots = seeks.length > 0 ? seeks.length : 1;
+    int *order = safe_malloc(sizeof(int) * slots);
+    ReplayStats stats = {.latencies = safe_malloc(sizeof(double) * slots)};
+
+    bool ok = true;
+
+    for (int i = 0; ok && i < schedulerCount; i++)
+    {
+        scheduleAll(seeks, i, order);
+
+        // Start every policy from a cold cache when the page cache is in
+        // play.
+        if (!target.direct)
+            posix_fadvise(target.fd, 0, 0, POSIX_FADV_DONTNEED);
+
+        if (useRing)
+            ok = replayRing(&ring, &target, order, seeks.length, depth,
+                            &stats);
+        else
+            replaySync(&target, order, seeks.length, &stats);
+
+        if (ok)
+            printReplayStats(schedulers[i].title, &target, &stats);
+    }
+
+    printf("\n");
+
+    free(stats.latencies);
+    free(order);
+    if (useRing)
+        ringFree(&ring);
+    close(target.fd);
+
+    return ok;
+}
+
+static bool openTarget(const char *path, Target *target)
+{
+    target->blockSize = envLong("D_REPLAY_BLOCK", REPLAY_BLOCK_SIZE);
+    target->direct = envLong("D_REPLAY_DIRECT", 1);
+
+    if (target->blockSize < 512 || target->blockSize % 512 != 0)
+    {
+        fprintf(stderr, "Read size must be a multiple of 512 bytes.\n");
+        return false;
+    }
+
+    target->fd = -1;
+
+    if (target->direct)
+        target->fd = open(path, O_RDONLY | O_DIRECT);
+
+    // Some filesystems (tmpfs, for one) refuse O_DIRECT.
+    if (target->fd < 0)
+    {
+        target->direct = false;
+        target->fd = open(path, O_RDONLY);
+    }
+
+    if (target->fd < 0)
+    {
+        fprintf(stderr, "Could not open target: %s (%s)\n", path,
+                strerror(errno));
+        return false;
+    }
+
+    struct stat info;
+    fstat(target->fd, &info);
+
+    unsigned long long size = info.st_size;
+    if (S_ISBLK(info.st_mode) && ioctl(target->fd, BLKGETSIZE64, &size) != 0)
+        size = 0;
+
+    target->size = size;
+
+    // Cylinders are spaced evenly, each stride rounded down to whole reads.
+    target->stride =
+        target->size / CYLINDERS / target->blockSize * target->blockSize;
+
+    if (target->size < target->blockSize)
+    {
+        fprintf(stderr, "Target is smaller than one read: %s\n", path);
+        close(target->fd);
+        return false;
+    }
+
+    return true;
+}
+
+static long long offsetOf(const Target *target, const int cylinder)
+{
+    long long offset = (long long)(cylinder - D_SIZE_MIN) * target->stride;
+
+    // Targets too small to give every cylinder its own block share them
+    // proportionally instead.
+    if (target->stride == 0)
+    {
+        long long blocks = target->size / target->blockSize;
+        offset = (long long)(cylinder - D_SIZE_MIN) * blocks / CYLINDERS *
+                 target->blockSize;
+    }
+
+    return offset;
+}
+
+static void scheduleAll(SeekList seeks, const int scheduler, int order[])
+{
+    Simulation sim;
+    simulationInit(&sim);
+
+    // Chunked exactly as a normal run would be, and like processChunk(),
+    // each scheduler starts from the order the one before it left, which
+    // decides how ties fall.
+    for (int i = 0; i < seeks.length; i += D_CHUNK_SIZE)
+    {
+        SeekList chunk = {&order[i], min(D_CHUNK_SIZE, seeks.length - i)};
+        memcpy(chunk.list, &seeks.list[i], sizeof(int) * chunk.length);
+
+        for (int j = 0; j <= scheduler; j++)
+            schedulers[j].schedule(&sim, &sim.states[j], &chunk);
+    }
+
+    simulationFree(&sim);
+}
+
+static bool ringInit(Ring *ring, const unsigned int entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0)
+        return false;
+
+    ring->entries = params.sq_entries;
+    ring->sqRingSize =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // Older kernels map the two rings separately.
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+    {
+        if (ring->cqRingSize > ring->sqRingSize)
+            ring->sqRingSize = ring->cqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    ring->sqRing =
+        mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cqRing = single ? ring->sqRing
+                          : mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring->fd,
+                                 IORING_OFF_CQ_RING);
+
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED ||
+        ring->sqes == MAP_FAILED)
+    {
+        close(ring->fd);
+        return false;
+    }
+
+    char *sq = ring->sqRing;
+    char *cq = ring->cqRing;
+
+    ring->sqHead = (unsigned int *)(sq + params.sq_off.head);
+    ring->sqTail = (unsigned int *)(sq + params.sq_off.tail);
+    ring->sqMask = (unsigned int *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int *)(sq + params.sq_off.array);
+    ring->cqHead = (unsigned int *)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned int *)(cq + params.cq_off.tail);
+    ring->cqMask = (unsigned int *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+static void ringFree(Ring *ring)
+{
+    munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->fd);
+}
+
+static bool replayRing(Ring *ring, const Target *target, const int order[],
+                       const int length, const int depth, ReplayStats *stats)
+{
+    int slots = min(depth, (int)ring->entries);
+    char *buffers;
+    if (posix_memalign((void **)&buffers, REPLAY_BLOCK_SIZE,
+                       (size_t)slots * target->blockSize) != 0)
+    {
+        fprintf(stderr, "Allocation error @ %s:%d\n", __FILE__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    double *issued = safe_malloc(sizeof(double) * slots);
+    int *freeSlots = safe_malloc(sizeof(int) * slots);
+    int freeCount = slots;
+    for (int i = 0; i < slots; i++)
+        freeSlots[i] = i;
+
+    stats->count = 0;
+    stats->errors = 0;
+
+    int next = 0;
+    int inFlight = 0;
+    int unsubmitted = 0;
+    bool ok = true;
+    double began = monotonicSeconds();
+
+    while ((ok && next < length) || inFlight > 0)
+    {
+        // Keep the queue topped up in schedule order.
+        unsigned int tail = *ring->sqTail;
+        int queued = 0;
+
+        while (ok && next < length && freeCount > 0)
+        {
+            int slot = freeSlots[--freeCount];
+            unsigned int index = tail & *ring->sqMask;
+            struct io_uring_sqe *sqe = &ring->sqes[index];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = target->fd;
+            sqe->addr =
+                (unsigned long)(buffers + (size_t)slot * target->blockSize);
+            sqe->len = target->blockSize;
+            sqe->off = offsetOf(target, order[next++]);
+            sqe->user_data = slot;
+
+            ring->sqArray[index] = index;
+            issued[slot] = monotonicSeconds();
+            tail++;
+            queued++;
+        }
+
+        __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+        inFlight += queued;
+        unsubmitted += queued;
+
+        // The kernel may take fewer than offered; the rest stay queued in
+        // the ring and are offered again next time round.
+        int entered = syscall(__NR_io_uring_enter, ring->fd, unsubmitted, 1,
+                              IORING_ENTER_GETEVENTS, NULL, 0);
+        if (entered < 0 && errno != EINTR && errno != EAGAIN &&
+            errno != EBUSY)
+        {
+            fprintf(stderr, "io_uring_enter failed: %s\n", strerror(errno));
+
+            // Reads the kernel has already taken still land in the
+            // buffers; if they can't be waited for, the buffers are left
+            // to them.
+            if (!ok)
+            {
+                free(freeSlots);
+                free(issued);
+                return false;
+            }
+
+            // Wait for those, and drop the rest.
+            ok = false;
+            inFlight -= unsubmitted;
+            unsubmitted = 0;
+            continue;
+        }
+
+        if (entered > 0)
+            unsubmitted -= entered;
+
+        // Reap whatever has completed.
+        unsigned int head = *ring->cqHead;
+        unsigned int cqTail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        double now = monotonicSeconds();
+
+        for (; head != cqTail; head++)
+        {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+            int slot = cqe->user_data;
+
+            // A short read didn't fetch the block, so it counts as failed.
+            if (cqe->res < target->blockSize)
+                stats->errors++;
+
+            stats->latencies[stats->count++] = now - issued[slot];
+            freeSlots[freeCount++] = slot;
+            inFlight--;
+        }
+
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    stats->elapsed = monotonicSeconds() - began;
+
+    free(freeSlots);
+    free(issued);
+    free(buffers);
+
+    return ok;
+}
+
+static void replaySync(const Target *target, const int order[],
+                       const int length, ReplayStats *stats)
+{
+    char *buffer;
+    if (posix_memalign((void **)&buffer, REPLAY_BLOCK_SIZE,
+                       target->blockSize) != 0)
+    {
+        fprintf(stderr, "Allocation error @ %s:%d\n", __FILE__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+
+    stats->count = 0;
+    stats->errors = 0;
+
+    double began = monotonicSeconds();
+
+    for (int i = 0; i < length; i++)
+    {
+        double issued = monotonicSeconds();
+
+        if (pread(target->fd, buffer, target->blockSize,
+                  offsetOf(target, order[i])) < target->blockSize)
+            stats->errors++;
+
+        stats->latencies[stats->count++] = monotonicSeconds() - issued;
+    }
+
+    stats->elapsed = monotonicSeconds() - began;
+
+    free(buffer);
+}
+
+static void printReplayStats(const char title[], const Target *target,
+                             ReplayStats *stats)
+{
+    printHeader(title);
+
+    double total = 0;
+    for (int i = 0; i < stats->count; i++)
+        total += stats->latencies[i];
+
+    qsort(stats->latencies, stats->count, sizeof(double), compareDoubles);
+
+    double iops = stats->elapsed > 0 ? stats->count / stats->elapsed : 0;
+    double mean = stats->count > 0 ? total / stats->count : 0;
+    double median = stats->count > 0 ? stats->latencies[stats->count / 2] : 0;
+    double tail =
+        stats->count > 0 ? stats->latencies[(stats->count - 1) * 99 / 100] : 0;
+    double worst = stats->count > 0 ? stats->latencies[stats->count - 1] : 0;
+
+    printf(
+        "Reads: %d (%d failed)\n"
+        "Elapsed: %.4f s\n"
+        "Throughput: %.1f IOPS (%.2f MiB/s)\n"
+        "Mean latency: %.1f us\n"
+        "Median latency: %.1f us\n"
+        "99th percentile latency: %.1f us\n"
+        "Maximum latency: %.1f us\n",
+        stats->count, stats->errors, stats->elapsed, iops,
+        iops * target->blockSize / (1024 * 1024), mean * 1e6, median * 1e6,
+        tail * 1e6, worst * 1e6);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,16 @@
+/**
+ * Replay of scheduled seeks against real storage
+ *
+ * @file replay.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "dass.h"
+
+bool replay(SeekList seeks, const char *target, const int depth);
+
+#endif
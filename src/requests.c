@@ -0,0 +1,170 @@
+/**
+ * Request table
+ *
+ * @file requests.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "histogram.h"
+
+static void *newColumn(const size_t width, const long capacity);
+static void *resizeColumn(void *column, const size_t width,
+                          const long capacity);
+static void growTable(RequestTable *table, const long capacity);
+
+void requestTableInit(RequestTable *table, const long capacity)
+{
+    *table = (RequestTable){0};
+    table->capacity = capacity > 0 ? capacity : D_DYNAMIC_BASE_SIZE;
+    table->cylinder = safe_malloc(sizeof(int) * table->capacity);
+    table->histogram = histogramCreate();
+}
+
+void requestTableFree(RequestTable *table)
+{
+    free(table->cylinder);
+    free(table->arrival);
+    free(table->op);
+    free(table->size);
+    free(table->tenant);
+    free(table->id);
+    free(table->histogram);
+    *table = (RequestTable){0};
+}
+
+void requestTableAddColumns(RequestTable *table, const unsigned int columns)
+{
+    unsigned int added = columns & ~table->columns;
+    table->columns |= columns;
+
+    // Rows that predate a column get zeroes, apart from IDs, which
+    // default to the row number.
+    if (added & REQUEST_ARRIVAL)
+        table->arrival = newColumn(sizeof(double), table->capacity);
+    if (added & REQUEST_OP)
+        table->op = newColumn(sizeof(unsigned char), table->capacity);
+    if (added & REQUEST_SIZE)
+        table->size = newColumn(sizeof(int), table->capacity);
+    if (added & REQUEST_TENANT)
+        table->tenant = newColumn(sizeof(int), table->capacity);
+    if (added & REQUEST_ID)
+    {
+        table->id = newColumn(sizeof(long), table->capacity);
+        for (long i = 0; i < table->length; i++)
+            table->id[i] = i;
+    }
+}
+
+long requestTableAppend(RequestTable *table, const int cylinder)
+{
+    if (table->length == table->capacity)
+        growTable(table, table->capacity * 2);
+
+    long row = table->length++;
+    table->cylinder[row] = cylinder;
+    if (table->histogram != NULL)
+        histogramAdd(table->histogram, cylinder);
+
+    if (table->columns & REQUEST_ARRIVAL)
+        table->arrival[row] = 0;
+    if (table->columns & REQUEST_OP)
+        table->op[row] = OP_UNKNOWN;
+    if (table->columns & REQUEST_SIZE)
+        table->size[row] = 0;
+    if (table->columns & REQUEST_TENANT)
+        table->tenant[row] = 0;
+    if (table->columns & REQUEST_ID)
+        table->id[row] = row;
+
+    return row;
+}
+
+void requestTableAppendMany(RequestTable *table, const int cylinders[],
+                            const long count)
+{
+    requestTableAppendCounted(table, cylinders, count, NULL);
+}
+
+void requestTableAppendCounted(RequestTable *table, const int cylinders[],
+                               const long count,
+                               const SeekHistogram *histogram)
+{
+    if (table->columns != 0)
+    {
+        // Optional columns need their defaults filled in row by row.
+        for (long i = 0; i < count; i++)
+            requestTableAppend(table, cylinders[i]);
+        return;
+    }
+
+    if (table->length + count > table->capacity)
+    {
+        long capacity = table->capacity;
+        while (capacity < table->length + count)
+            capacity *= 2;
+        growTable(table, capacity);
+    }
+
+    memcpy(table->cylinder + table->length, cylinders, sizeof(int) * count);
+    table->length += count;
+
+    // Counted already when the caller could do it in parallel
+    if (table->histogram == NULL)
+        return;
+    else if (histogram != NULL)
+        histogramMerge(table->histogram, histogram);
+    else
+        histogramAddMany(table->histogram, cylinders, count);
+}
+
+SeekList requestTableSeeks(const RequestTable *table)
+{
+    // The schedulers count in ints; a table past that has to be converted
+    // and simulated block by block instead.
+    if (table->length > INT_MAX)
+    {
+        fprintf(stderr, "Too many requests to schedule at once: %ld\n",
+                table->length);
+        return (SeekList){NULL, 0};
+    }
+
+    return (SeekList){table->cylinder, table->length};
+}
+
+static void *newColumn(const size_t width, const long capacity)
+{
+    void *column = safe_malloc(width * capacity);
+    memset(column, 0, width * capacity);
+    return column;
+}
+
+static void *resizeColumn(void *column, const size_t width,
+                          const long capacity)
+{
+    // Columns that were never added stay unallocated.
+    if (column == NULL)
+        return NULL;
+
+    return safe_realloc(column, width * capacity);
+}
+
+static void growTable(RequestTable *table, const long capacity)
+{
+    table->capacity = capacity;
+    table->cylinder =
+        resizeColumn(table->cylinder, sizeof(int), table->capacity);
+    table->arrival =
+        resizeColumn(table->arrival, sizeof(double), table->capacity);
+    table->op =
+        resizeColumn(table->op, sizeof(unsigned char), table->capacity);
+    table->size = resizeColumn(table->size, sizeof(int), table->capacity);
+    table->tenant = resizeColumn(table->tenant, sizeof(int), table->capacity);
+    table->id = resizeColumn(table->id, sizeof(long), table->capacity);
+}
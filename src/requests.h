@@ -0,0 +1,78 @@
+/**
+ * Request table
+ *
+ * Requests are stored column by column. Cylinders sit in their own dense
+ * array, which is all the schedulers ever scan, and the rest of the
+ * metadata lives in parallel arrays that are only allocated once a source
+ * actually provides them.
+ *
+ * @file requests.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef REQUESTS_H
+#define REQUESTS_H
+
+#include <stdio.h>
+
+#include "dass.h"
+
+// Optional columns
+#define REQUEST_ARRIVAL 0x01
+#define REQUEST_OP 0x02
+#define REQUEST_SIZE 0x04
+#define REQUEST_TENANT 0x08
+#define REQUEST_ID 0x10
+
+typedef enum RequestOp
+{
+    OP_UNKNOWN,
+    OP_READ,
+    OP_WRITE
+} RequestOp;
+
+// A single request on its way through a stream, never stored in bulk
+typedef struct Request
+{
+    int cylinder;
+    double arrival;
+    RequestOp op;
+    int size;
+    int tenant;
+} Request;
+
+typedef struct RequestTable
+{
+    int *cylinder;
+
+    double *arrival;
+    unsigned char *op;
+    int *size;
+    int *tenant;
+    long *id;
+
+    unsigned int columns;
+    long length;
+    long capacity;
+
+    // Cylinders counted as they're appended, unless this is NULL because
+    // the counts are already known
+    SeekHistogram *histogram;
+} RequestTable;
+
+void requestTableInit(RequestTable *table, const long capacity);
+void requestTableFree(RequestTable *table);
+void requestTableAddColumns(RequestTable *table, const unsigned int columns);
+long requestTableAppend(RequestTable *table, const int cylinder);
+void requestTableAppendMany(RequestTable *table, const int cylinders[],
+                            const long count);
+void requestTableAppendCounted(RequestTable *table, const int cylinders[],
+                               const long count,
+                               const SeekHistogram *histogram);
+SeekList requestTableSeeks(const RequestTable *table);
+
+bool extractSeeks(FILE *stream, const char *source, RequestTable *requests);
+bool readSeekFile(const char *path, RequestTable *requests);
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * Shared-memory request ring
+ *
+ * @file shmring.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dass.h"
+#include "parse.h"
+#include "writer.h"
+#include "shmring.h"
+
+// Requests moved per read or write
+#define SHM_RING_BATCH 4096
+
+// Waiting: spin, then yield, then sleep for longer and longer up to a cap
+#define SHM_RING_SPINS 256
+#define SHM_RING_YIELDS 64
+#define SHM_RING_SLEEP_MAX 1000000
+
+_Static_assert(offsetof(ShmRingHeader, head) == 64, "ring layout");
+_Static_assert(offsetof(ShmRingHeader, tail) == 128, "ring layout");
+_Static_assert(offsetof(ShmRingHeader, slots) == 192, "ring layout");
+_Static_assert(sizeof(int) == sizeof(int32_t), "seeks go into slots as-is");
+
+static volatile sig_atomic_t interrupted;
+
+static bool mapRing(ShmRing *ring, const int fd, const size_t size);
+static void backOff(int *waits);
+static bool producerGone(const ShmRing *ring);
+static void interrupt(int signal);
+
+bool shmRingCreate(ShmRing *ring, const char *name, const uint32_t capacity)
+{
+    if (capacity < 1 || capacity > SHM_RING_CAPACITY_MAX)
+    {
+        fprintf(stderr, "Ring capacity must be between 1 and %d\n",
+                SHM_RING_CAPACITY_MAX);
+        return false;
+    }
+
+    uint32_t slots = 2;
+    while (slots < capacity)
+        slots *= 2;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Could not create shared memory %s: %s\n", name,
+                strerror(errno));
+        return false;
+    }
+
+    size_t size = sizeof(ShmRingHeader) + sizeof(int32_t) * slots;
+
+    if (ftruncate(fd, size) != 0 || !mapRing(ring, fd, size))
+    {
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    close(fd);
+
+    ring->owner = true;
+    ring->name = strdup(name);
+
+    // A fresh segment is zeroed; the magic goes last so a producer that
+    // attaches early never sees a half-made ring.
+    ring->header->version = SHM_RING_VERSION;
+    ring->header->capacity = slots;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(ring->header->magic, SHM_RING_MAGIC, 4);
+
+    return true;
+}
+
+bool shmRingAttach(ShmRing *ring, const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Could not attach to shared memory %s: %s\n", name,
+                strerror(errno));
+        return false;
+    }
+
+    ShmRingHeader header;
+
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        memcmp(header.magic, SHM_RING_MAGIC, 4) != 0 ||
+        header.version != SHM_RING_VERSION || header.capacity == 0 ||
+        (header.capacity & (header.capacity - 1)) != 0)
+    {
+        fprintf(stderr, "Not a request ring: %s\n", name);
+        close(fd);
+        return false;
+    }
+
+    bool ok = mapRing(ring, fd,
+                      sizeof(ShmRingHeader) +
+                          sizeof(int32_t) * header.capacity);
+    close(fd);
+
+    if (!ok)
+        return false;
+
+    ring->owner = false;
+    ring->name = strdup(name);
+
+    uint32_t unclaimed = 0;
+
+    if (!__atomic_compare_exchange_n(&ring->header->producer, &unclaimed,
+                                     (uint32_t)getpid(), false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        fprintf(stderr, "Request ring %s already has a producer\n", name);
+        shmRingClose(ring);
+        return false;
+    }
+
+    return true;
+}
+
+void shmRingClose(ShmRing *ring)
+{
+    munmap(ring->header, ring->size);
+
+    if (ring->owner)
+        shm_unlink(ring->name);
+
+    free(ring->name);
+    *ring = (ShmRing){0};
+}
+
+size_t shmRingWrite(ShmRing *ring, const int32_t cylinders[],
+                    const size_t count)
+{
+    ShmRingHeader *header = ring->header;
+    uint64_t tail = header->tail;
+    uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+
+    size_t room = header->capacity - (tail - head);
+    size_t written = count < room ? count : room;
+    uint32_t mask = header->capacity - 1;
+
+    for (size_t i = 0; i < written; i++)
+        header->slots[(tail + i) & mask] = cylinders[i];
+
+    __atomic_store_n(&header->tail, tail + written, __ATOMIC_RELEASE);
+
+    return written;
+}
+
+size_t shmRingRead(ShmRing *ring, int32_t cylinders[], const size_t max)
+{
+    ShmRingHeader *header = ring->header;
+    uint64_t head = header->head;
+    uint64_t tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+
+    size_t waiting = tail - head;
+    size_t read = max < waiting ? max : waiting;
+    uint32_t mask = header->capacity - 1;
+
+    for (size_t i = 0; i < read; i++)
+        cylinders[i] = header->slots[(head + i) & mask];
+
+    __atomic_store_n(&header->head, head + read, __ATOMIC_RELEASE);
+
+    return read;
+}
+
+void shmRingFinish(ShmRing *ring)
+{
+    __atomic_store_n(&ring->header->closed, 1, __ATOMIC_RELEASE);
+}
+
+bool shmRingFinished(const ShmRing *ring)
+{
+    // Closed first, then empty: nothing can slip in between.
+    return __atomic_load_n(&ring->header->closed, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE) ==
+               ring->header->head;
+}
+
+bool consumeShmRing(const char *name)
+{
+    ShmRing ring;
+    long capacity = envLong("D_SHM_CAPACITY", SHM_RING_CAPACITY);
+
+    if (capacity < 1 || capacity > SHM_RING_CAPACITY_MAX)
+    {
+        fprintf(stderr, "D_SHM_CAPACITY must be between 1 and %d\n",
+                SHM_RING_CAPACITY_MAX);
+        return false;
+    }
+
+    if (!shmRingCreate(&ring, name, capacity))
+        return false;
+
+    Simulation sim;
+    simulationInit(&sim);
+    writerStart(&sim);
+
+    int32_t *cylinders = safe_malloc(sizeof(int32_t) * SHM_RING_BATCH);
+    long outOfRange = 0;
+    int waits = 0;
+    bool abandoned = false;
+
+    // Stop cleanly on an interrupt, so the segment is still removed.
+    struct sigaction action = {.sa_handler = interrupt};
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    while (!interrupted)
+    {
+        size_t count = shmRingRead(&ring, cylinders, SHM_RING_BATCH);
+
+        if (count == 0)
+        {
+            if (shmRingFinished(&ring))
+                break;
+
+            // Only looked into once waiting has turned to sleeping; the
+            // ring is read once more in case it filled in the meantime.
+            if (waits >= SHM_RING_SPINS + SHM_RING_YIELDS &&
+                producerGone(&ring))
+            {
+                if (abandoned)
+                    break;
+
+                abandoned = true;
+                continue;
+            }
+
+            backOff(&waits);
+            continue;
+        }
+
+        waits = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (D_SIZE_MIN <= cylinders[i] && cylinders[i] <= D_SIZE_MAX)
+                simulationFeed(&sim, cylinders[i]);
+            else
+                outOfRange++;
+        }
+    }
+
+    simulationFinish(&sim);
+
+    if (abandoned)
+    {
+        fprintf(stderr, "Producer exited without finishing the ring: %s\n",
+                name);
+    }
+
+    if (outOfRange > 0)
+        fprintf(stderr, "Requests out of range: %ld\n", outOfRange);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    free(cylinders);
+    shmRingClose(&ring);
+
+    return !abandoned;
+}
+
+bool feedShmRing(const char *name, FILE *in, const char *source)
+{
+    ShmRing ring;
+
+    if (!shmRingAttach(&ring, name))
+        return false;
+
+    Validation validation;
+    validationInit(&validation);
+
+    char *line = NULL;
+    size_t capacity = 0;
+    int *seeks = NULL;
+    int seeksCapacity = 0;
+    ssize_t length;
+
+    while (!validation.failed &&
+           (length = getline(&line, &capacity, in)) > 0)
+    {
+        if (length / 2 + 1 > seeksCapacity)
+        {
+            seeksCapacity = length / 2 + 1;
+            seeks = safe_realloc(seeks, sizeof(int) * seeksCapacity);
+        }
+
+        int count = parseSeekText(line, line + length, seeks, &validation);
+
+        // A full ring holds the producer back until the consumer catches up.
+        for (int done = 0, waits = 0; done < count;)
+        {
+            size_t written =
+                shmRingWrite(&ring, (int32_t *)seeks + done, count - done);
+
+            if (written == 0)
+                backOff(&waits);
+            else
+                waits = 0;
+
+            done += written;
+        }
+    }
+
+    shmRingFinish(&ring);
+
+    free(line);
+    free(seeks);
+    shmRingClose(&ring);
+
+    return validationReport(&validation, source);
+}
+
+static bool mapRing(ShmRing *ring, const int fd, const size_t size)
+{
+    void *memory =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (memory == MAP_FAILED)
+    {
+        fprintf(stderr, "Could not map shared memory: %s\n", strerror(errno));
+        return false;
+    }
+
+    ring->header = memory;
+    ring->size = size;
+
+    return true;
+}
+
+static bool producerGone(const ShmRing *ring)
+{
+    pid_t producer = __atomic_load_n(&ring->header->producer,
+                                     __ATOMIC_ACQUIRE);
+
+    // Not attached yet isn't gone; EPERM means it's alive as someone else.
+    return producer != 0 && kill(producer, 0) != 0 && errno == ESRCH;
+}
+
+static void interrupt(int signal)
+{
+    (void)signal;
+    interrupted = 1;
+}
+
+static void backOff(int *waits)
+{
+    int wait = (*waits)++;
+
+    if (wait < SHM_RING_SPINS)
+        return;
+
+    if (wait < SHM_RING_SPINS + SHM_RING_YIELDS)
+    {
+        sched_yield();
+        return;
+    }
+
+    // An idle producer shouldn't cost a core.
+    long nanoseconds = 1000L << min(wait - SHM_RING_SPINS - SHM_RING_YIELDS,
+                                    10);
+    if (nanoseconds > SHM_RING_SLEEP_MAX)
+        nanoseconds = SHM_RING_SLEEP_MAX;
+
+    nanosleep(&(struct timespec){0, nanoseconds}, NULL);
+}
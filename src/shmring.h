@@ -0,0 +1,83 @@
+/**
+ * Shared-memory request ring
+ *
+ * One producer on the same host (a tracing agent, say) writes cylinders
+ * into a POSIX shared-memory ring, and the simulator consumes them straight out
+ * of it: no text, and no system calls while there is work to do. Each side
+ * owns one index and only ever reads the other's, so neither takes a lock.
+ *
+ * Layout of the segment, in host byte order:
+ *   0     magic "DSHM"
+ *   4     version (uint32)
+ *   8     capacity in requests, a power of two (uint32)
+ *   12    closed: set non-zero by the producer once it is done (uint32)
+ *   16    producer: process ID of the producer, set as it attaches
+ *         (uint32)
+ *   64    head: requests consumed so far (uint64, consumer-owned)
+ *   128   tail: requests produced so far (uint64, producer-owned)
+ *   192   slots: int32 cylinders, slot = index % capacity
+ *
+ * The consumer creates the segment and removes it when done; the producer
+ * attaches to it by name. Each index has a single writer, so a second
+ * producer is turned away rather than allowed to race the first. A
+ * producer that exits without finishing the ring is noticed while the
+ * consumer waits, and an interrupted consumer still removes the segment.
+ *
+ * The capacity is rounded up to a power of two, at most
+ * SHM_RING_CAPACITY_MAX requests (D_SHM_CAPACITY).
+ *
+ * @file shmring.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dass.h"
+
+#define SHM_RING_MAGIC "DSHM"
+#define SHM_RING_VERSION 2
+#define SHM_RING_CAPACITY (1 << 16)
+#define SHM_RING_CAPACITY_MAX (1 << 30)
+#define SHM_RING_CACHE_LINE 64
+
+typedef struct ShmRingHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t closed;
+    uint32_t producer;
+
+    _Alignas(SHM_RING_CACHE_LINE) uint64_t head;
+    _Alignas(SHM_RING_CACHE_LINE) uint64_t tail;
+    _Alignas(SHM_RING_CACHE_LINE) int32_t slots[];
+} ShmRingHeader;
+
+typedef struct ShmRing
+{
+    ShmRingHeader *header;
+    size_t size;
+    char *name;
+    bool owner;
+} ShmRing;
+
+bool shmRingCreate(ShmRing *ring, const char *name, const uint32_t capacity);
+bool shmRingAttach(ShmRing *ring, const char *name);
+void shmRingClose(ShmRing *ring);
+
+size_t shmRingWrite(ShmRing *ring, const int32_t cylinders[],
+                    const size_t count);
+size_t shmRingRead(ShmRing *ring, int32_t cylinders[], const size_t max);
+void shmRingFinish(ShmRing *ring);
+bool shmRingFinished(const ShmRing *ring);
+
+bool consumeShmRing(const char *name);
+bool feedShmRing(const char *name, FILE *in, const char *source);
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * Bounded single-producer, single-consumer queues
+ *
+ * @file spsc.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdlib.h>
+#include <sched.h>
+
+#include "dass.h"
+#include "spsc.h"
+
+// Spins before giving up the processor while waiting on the other side
+#define SPSC_SPINS 64
+
+static void wait(int *spins);
+
+void spscInit(SpscQueue *queue, const size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+
+    *queue = (SpscQueue){
+        .slots = safe_malloc(sizeof(void *) * size),
+        .mask = size - 1,
+    };
+}
+
+void spscFree(SpscQueue *queue)
+{
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+bool spscTryPush(SpscQueue *queue, void *item)
+{
+    size_t tail = queue->tail;
+
+    if (tail - queue->headCache > queue->mask)
+    {
+        queue->headCache = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+        if (tail - queue->headCache > queue->mask)
+            return false;
+    }
+
+    queue->slots[tail & queue->mask] = item;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool spscTryPop(SpscQueue *queue, void **item)
+{
+    size_t head = queue->head;
+
+    if (head == queue->tailCache)
+    {
+        queue->tailCache = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+        if (head == queue->tailCache)
+            return false;
+    }
+
+    *item = queue->slots[head & queue->mask];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+void spscPush(SpscQueue *queue, void *item)
+{
+    int spins = 0;
+
+    while (!spscTryPush(queue, item))
+        wait(&spins);
+}
+
+void *spscPop(SpscQueue *queue)
+{
+    void *item;
+    int spins = 0;
+
+    while (!spscTryPop(queue, &item))
+        wait(&spins);
+
+    return item;
+}
+
+static void wait(int *spins)
+{
+    if (++*spins < SPSC_SPINS)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    else
+    {
+        sched_yield();
+    }
+}
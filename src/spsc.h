@@ -0,0 +1,43 @@
+/**
+ * Bounded single-producer, single-consumer queues
+ *
+ * A ring of pointers with one index owned by each side, so neither side
+ * ever takes a lock. A full queue holds its producer back, which is what
+ * keeps a fast stage from running away from a slow one.
+ *
+ * @file spsc.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stddef.h>
+
+#include "dass.h"
+
+#define SPSC_CACHE_LINE 64
+
+typedef struct SpscQueue
+{
+    void **slots;
+    size_t mask;
+
+    // Each side's index, and its last look at the other's, share a line
+    // that the other side only ever reads.
+    _Alignas(SPSC_CACHE_LINE) size_t tail;
+    size_t headCache;
+
+    _Alignas(SPSC_CACHE_LINE) size_t head;
+    size_t tailCache;
+} SpscQueue;
+
+void spscInit(SpscQueue *queue, const size_t capacity);
+void spscFree(SpscQueue *queue);
+bool spscTryPush(SpscQueue *queue, void *item);
+bool spscTryPop(SpscQueue *queue, void **item);
+void spscPush(SpscQueue *queue, void *item);
+void *spscPop(SpscQueue *queue);
+
+#endif
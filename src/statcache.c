@@ -0,0 +1,229 @@
+/**
+ * Sidecar statistics cache
+ *
+ * @file statcache.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "trace.h"
+#include "statcache.h"
+
+#define FNV_PRIME 0x100000001b3ull
+#define HASH_BUFFER_SIZE 65536
+
+static char *sidecarPath(const char *path);
+static bool traceIdentity(const char *path, StatCache *cache);
+
+bool statCacheEnabled(void)
+{
+    const char *enabled = getenv("D_STATS_CACHE");
+    return enabled != NULL && !streq(enabled, "0");
+}
+
+StatCache *statCacheFind(const char *path)
+{
+    if (!statCacheEnabled())
+        return NULL;
+
+    StatCache *cache = safe_malloc(sizeof(StatCache));
+
+    if (!statCacheLoad(path, cache))
+    {
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+bool statCacheLoad(const char *path, StatCache *cache)
+{
+    StatCache current;
+
+    if (!traceIdentity(path, &current))
+        return false;
+
+    char *sidecar = sidecarPath(path);
+    FILE *file = fopen(sidecar, "rb");
+    free(sidecar);
+
+    if (file == NULL)
+        return false;
+
+    // Sidecars never leave the machine that wrote them, so the cache is
+    // stored as-is rather than in a portable byte order.
+    char magic[4];
+    uint32_t version;
+    bool ok = fread(magic, 1, 4, file) == 4 &&
+              memcmp(magic, STAT_CACHE_MAGIC, 4) == 0 &&
+              fread(&version, sizeof(version), 1, file) == 1 &&
+              version == STAT_CACHE_VERSION &&
+              fread(cache, sizeof(StatCache), 1, file) == 1;
+
+    fclose(file);
+
+    if (!ok || cache->size != current.size || cache->mtime != current.mtime ||
+        cache->mtimeNanoseconds != current.mtimeNanoseconds)
+    {
+        return false;
+    }
+
+    // Size and time catch nearly every edit; the hash catches the rest.
+    // A sidecar written without one is rebuilt.
+    if (getenv("D_STATS_VERIFY") != NULL)
+    {
+        uint64_t hash = hashFile(path, &ok);
+        return ok && cache->hashed && hash == cache->hash;
+    }
+
+    return true;
+}
+
+bool statCacheStore(const char *path, const StatCache *cache)
+{
+    char *sidecar = sidecarPath(path);
+    FILE *file = fopen(sidecar, "wb");
+    free(sidecar);
+
+    if (file == NULL)
+        return false;
+
+    uint32_t version = STAT_CACHE_VERSION;
+    bool ok = fwrite(STAT_CACHE_MAGIC, 1, 4, file) == 4 &&
+              fwrite(&version, sizeof(version), 1, file) == 1 &&
+              fwrite(cache, sizeof(StatCache), 1, file) == 1;
+
+    return fclose(file) == 0 && ok;
+}
+
+bool statCacheBuild(const char *path, SeekList seeks,
+                    const SeekHistogram *histogram, StatCache *cache)
+{
+    // The struct is written out whole, padding and all.
+    memset(cache, 0, sizeof(StatCache));
+    cache->stats.min = D_SIZE_MAX;
+    cache->stats.max = D_SIZE_MIN;
+
+    if (!traceIdentity(path, cache))
+        return false;
+
+    bool ok = true;
+
+    if (getenv("D_STATS_VERIFY") != NULL)
+    {
+        cache->hash = hashFile(path, &ok);
+        cache->hashed = ok;
+    }
+
+    for (int i = 0; i < seeks.length; i++)
+        traceStatsAdd(&cache->stats, seeks.list[i]);
+
+    if (histogram != NULL)
+        cache->histogram = *histogram;
+    else
+        histogramAddMany(&cache->histogram, seeks.list, seeks.length);
+
+    return ok;
+}
+
+StatCache *statCacheApply(Simulation *sim, const char *path, SeekList seeks,
+                          StatCache *cache)
+{
+    if (!statCacheEnabled())
+        return NULL;
+
+    // Without a sidecar found beforehand, the trace was counted as it was
+    // read, and that histogram goes into a new one.
+    if (cache == NULL)
+    {
+        cache = safe_malloc(sizeof(StatCache));
+
+        if (!statCacheBuild(path, seeks, sim->histogram, cache) ||
+            !statCacheStore(path, cache))
+        {
+            fprintf(stderr, "Could not write statistics cache for: %s\n",
+                    path);
+            free(cache);
+            return NULL;
+        }
+    }
+
+    sim->statsKnown = true;
+    sim->seekCount = cache->stats.count;
+    sim->seekSum = cache->stats.sum;
+    sim->seekSumOfSquares = cache->stats.sumOfSquares;
+
+    if (sim->histogram == NULL)
+        sim->histogram = &cache->histogram;
+
+    return cache;
+}
+
+uint64_t hashFile(const char *path, bool *ok)
+{
+    FILE *file = fopen(path, "rb");
+    *ok = file != NULL;
+
+    if (file == NULL)
+        return 0;
+
+    unsigned char *buffer = safe_malloc(HASH_BUFFER_SIZE);
+    uint64_t hash = HASH_SEED;
+    size_t length;
+
+    while ((length = fread(buffer, 1, HASH_BUFFER_SIZE, file)) > 0)
+        hash = hashBytes(buffer, length, hash);
+
+    *ok = !ferror(file);
+
+    free(buffer);
+    fclose(file);
+
+    return hash;
+}
+
+uint64_t hashBytes(const void *bytes, const size_t length, uint64_t hash)
+{
+    // FNV-1a
+    const unsigned char *p = bytes;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static char *sidecarPath(const char *path)
+{
+    size_t length = strlen(path);
+    char *sidecar = safe_malloc(length + sizeof(STAT_CACHE_SUFFIX));
+
+    memcpy(sidecar, path, length);
+    memcpy(sidecar + length, STAT_CACHE_SUFFIX, sizeof(STAT_CACHE_SUFFIX));
+
+    return sidecar;
+}
+
+static bool traceIdentity(const char *path, StatCache *cache)
+{
+    struct stat info;
+
+    if (stat(path, &info) != 0)
+        return false;
+
+    cache->size = info.st_size;
+    cache->mtime = info.st_mtim.tv_sec;
+    cache->mtimeNanoseconds = info.st_mtim.tv_nsec;
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/**
+ * Sidecar statistics cache
+ *
+ * Whole-trace statistics are kept in "<trace>.stats" beside each trace so
+ * that repeated runs over an unchanged trace skip the statistics pass:
+ * the totals and the cylinder histogram both come from the sidecar, so
+ * nothing is counted while the trace is read. The trace is still read and
+ * parsed every run, since the schedulers need every request. A sidecar is
+ * trusted only while the trace's size and modification time match; with
+ * D_STATS_VERIFY set, the content hash is checked as well, and the trace
+ * is only hashed then.
+ *
+ * @file statcache.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef STATCACHE_H
+#define STATCACHE_H
+
+#include <stdint.h>
+
+#include "dass.h"
+#include "trace.h"
+#include "histogram.h"
+
+#define STAT_CACHE_MAGIC "DSTC"
+#define STAT_CACHE_VERSION 3
+#define STAT_CACHE_SUFFIX ".stats"
+
+// Starting value for hashBytes() (the FNV-1a offset basis)
+#define HASH_SEED 0xcbf29ce484222325ull
+
+typedef struct StatCache
+{
+    uint64_t size;
+    int64_t mtime;
+    int64_t mtimeNanoseconds;
+    uint64_t hash;
+    bool hashed;
+
+    TraceStats stats;
+    SeekHistogram histogram;
+} StatCache;
+
+bool statCacheEnabled(void);
+StatCache *statCacheFind(const char *path);
+bool statCacheLoad(const char *path, StatCache *cache);
+bool statCacheStore(const char *path, const StatCache *cache);
+bool statCacheBuild(const char *path, SeekList seeks,
+                    const SeekHistogram *histogram, StatCache *cache);
+StatCache *statCacheApply(Simulation *sim, const char *path, SeekList seeks,
+                          StatCache *cache);
+
+uint64_t hashFile(const char *path, bool *ok);
+uint64_t hashBytes(const void *bytes, const size_t length, uint64_t hash);
+
+#endif
@@ -0,0 +1,671 @@
+/**
+ * Compressed trace format
+ *
+ * @file trace.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#include "dass.h"
+#include "requests.h"
+#include "trace.h"
+#include "writer.h"
+
+#define HEADER_BYTES 32
+#define INDEX_ENTRY_BYTES 48
+#define CONTINUATION 0x80
+#define ALL_CONTINUATIONS 0x8080808080808080ull
+
+static void flushBlock(TraceWriter *writer);
+static void putU32(uint8_t *bytes, const uint32_t value);
+static void putU64(uint8_t *bytes, const uint64_t value);
+static uint32_t getU32(const uint8_t *bytes);
+static uint64_t getU64(const uint8_t *bytes);
+
+bool isCompressedTrace(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    char magic[4];
+
+    bool compressed = file != NULL && fread(magic, 1, 4, file) == 4 &&
+                      memcmp(magic, TRACE_MAGIC, 4) == 0;
+
+    if (file != NULL)
+        fclose(file);
+
+    return compressed;
+}
+
+bool traceWriterOpen(TraceWriter *writer, FILE *out)
+{
+    *writer = (TraceWriter){
+        .out = out,
+        .blockLength = TRACE_BLOCK_LENGTH,
+        .blockCapacity = D_DYNAMIC_BASE_SIZE,
+    };
+
+    writer->pending = safe_malloc(sizeof(int) * writer->blockLength);
+    writer->buffer = safe_malloc(writer->blockLength * TRACE_MAX_VARINT);
+    writer->blocks = safe_malloc(sizeof(TraceBlock) * writer->blockCapacity);
+
+    // The header is rewritten once the totals are known.
+    uint8_t header[HEADER_BYTES] = {0};
+    return fwrite(header, 1, HEADER_BYTES, out) == HEADER_BYTES;
+}
+
+void traceWriterAdd(TraceWriter *writer, const int cylinder)
+{
+    writer->pending[writer->pendingLength++] = cylinder;
+    writer->count++;
+
+    if (writer->pendingLength == writer->blockLength)
+        flushBlock(writer);
+}
+
+bool traceWriterClose(TraceWriter *writer)
+{
+    if (writer->pendingLength > 0)
+        flushBlock(writer);
+
+    uint64_t indexOffset = ftell(writer->out);
+    uint8_t entry[INDEX_ENTRY_BYTES];
+    bool ok = true;
+
+    for (uint32_t i = 0; i < writer->blockCount; i++)
+    {
+        const TraceBlock *block = &writer->blocks[i];
+
+        putU64(entry, block->offset);
+        putU64(entry + 8, block->first);
+        putU32(entry + 16, block->bytes);
+        putU32(entry + 20, block->stats.count);
+        putU32(entry + 24, block->stats.min);
+        putU32(entry + 28, block->stats.max);
+        putU64(entry + 32, block->stats.sum);
+        putU64(entry + 40, block->stats.sumOfSquares);
+        ok &= fwrite(entry, 1, INDEX_ENTRY_BYTES, writer->out) ==
+              INDEX_ENTRY_BYTES;
+    }
+
+    uint8_t header[HEADER_BYTES];
+    memcpy(header, TRACE_MAGIC, 4);
+    putU32(header + 4, TRACE_VERSION);
+    putU32(header + 8, writer->blockLength);
+    putU32(header + 12, writer->blockCount);
+    putU64(header + 16, writer->count);
+    putU64(header + 24, indexOffset);
+
+    ok &= fseek(writer->out, 0, SEEK_SET) == 0 &&
+          fwrite(header, 1, HEADER_BYTES, writer->out) == HEADER_BYTES;
+
+    free(writer->pending);
+    free(writer->buffer);
+    free(writer->blocks);
+
+    return ok;
+}
+
+bool traceReaderOpen(TraceReader *reader, FILE *in)
+{
+    *reader = (TraceReader){.in = in};
+
+    uint8_t header[HEADER_BYTES];
+
+    if (fread(header, 1, HEADER_BYTES, in) != HEADER_BYTES ||
+        memcmp(header, TRACE_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "Not a compressed trace.\n");
+        return false;
+    }
+
+    if (getU32(header + 4) != TRACE_VERSION)
+    {
+        fprintf(stderr, "Unsupported trace version: %u\n", getU32(header + 4));
+        return false;
+    }
+
+    reader->blockLength = getU32(header + 8);
+    reader->blockCount = getU32(header + 12);
+    reader->count = getU64(header + 16);
+    uint64_t indexOffset = getU64(header + 24);
+
+    // Nothing is allocated from the header until it fits the file.
+    struct stat info;
+
+    if (fstat(fileno(in), &info) != 0 || reader->blockLength == 0 ||
+        reader->blockLength > TRACE_BLOCK_LENGTH_MAX ||
+        indexOffset < HEADER_BYTES || indexOffset > (uint64_t)info.st_size ||
+        reader->blockCount >
+            ((uint64_t)info.st_size - indexOffset) / INDEX_ENTRY_BYTES)
+    {
+        fprintf(stderr, "Corrupt trace header.\n");
+        return false;
+    }
+
+    const size_t blockBytes = (size_t)reader->blockLength * TRACE_MAX_VARINT;
+
+    reader->blocks = safe_malloc(sizeof(TraceBlock) * reader->blockCount);
+    reader->buffer = safe_malloc(blockBytes + 8);
+
+    uint8_t entry[INDEX_ENTRY_BYTES];
+    uint64_t expected = 0;
+    fseek(in, indexOffset, SEEK_SET);
+
+    for (uint32_t i = 0; i < reader->blockCount; i++)
+    {
+        if (fread(entry, 1, INDEX_ENTRY_BYTES, in) != INDEX_ENTRY_BYTES)
+        {
+            fprintf(stderr, "Truncated trace index.\n");
+            traceReaderClose(reader);
+            return false;
+        }
+
+        TraceBlock *block = &reader->blocks[i];
+
+        block->offset = getU64(entry);
+        block->first = getU64(entry + 8);
+        block->bytes = getU32(entry + 16);
+        block->stats = (TraceStats){
+            .count = getU32(entry + 20),
+            .min = getU32(entry + 24),
+            .max = getU32(entry + 28),
+            .sum = getU64(entry + 32),
+            .sumOfSquares = getU64(entry + 40),
+        };
+
+        // Lookups rely on the blocks tiling the requests exactly, and an
+        // empty block would read as the end of the trace.
+        if (block->first != expected || block->stats.count == 0 ||
+            block->stats.count > reader->blockLength ||
+            block->bytes > blockBytes)
+        {
+            fprintf(stderr, "Corrupt trace index.\n");
+            traceReaderClose(reader);
+            return false;
+        }
+
+        expected += block->stats.count;
+    }
+
+    if (expected != reader->count)
+    {
+        fprintf(stderr, "Corrupt trace index.\n");
+        traceReaderClose(reader);
+        return false;
+    }
+
+    return true;
+}
+
+int traceReaderNext(TraceReader *reader, int cylinders[])
+{
+    if (reader->next >= reader->blockCount)
+        return 0;
+
+    return traceReaderBlock(reader, reader->next, cylinders);
+}
+
+int traceReaderBlock(TraceReader *reader, const uint32_t block,
+                     int cylinders[])
+{
+    if (block >= reader->blockCount)
+        return 0;
+
+    const TraceBlock *entry = &reader->blocks[block];
+
+    if (fseek(reader->in, entry->offset, SEEK_SET) != 0 ||
+        fread(reader->buffer, 1, entry->bytes, reader->in) != entry->bytes)
+    {
+        fprintf(stderr, "Truncated trace block: %u\n", block);
+        return -1;
+    }
+
+    reader->next = block + 1;
+
+    size_t decoded = decodeDeltas(reader->buffer, entry->bytes, cylinders,
+                                  entry->stats.count);
+
+    // Tables indexed by cylinder downstream rely on this.
+    for (size_t i = 0; decoded == entry->stats.count && i < decoded; i++)
+    {
+        if (cylinders[i] < D_SIZE_MIN || cylinders[i] > D_SIZE_MAX)
+            decoded = i;
+    }
+
+    if (decoded != entry->stats.count)
+    {
+        fprintf(stderr, "Corrupt trace block: %u\n", block);
+        return -1;
+    }
+
+    return entry->stats.count;
+}
+
+uint32_t traceReaderFind(const TraceReader *reader, const uint64_t request)
+{
+    // Last block starting at or before the request
+    uint32_t low = 0;
+    uint32_t high = reader->blockCount;
+
+    while (high - low > 1)
+    {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (reader->blocks[middle].first <= request)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+bool traceReaderStats(TraceReader *reader, const uint64_t first,
+                      const uint64_t count, TraceStats *stats)
+{
+    *stats = (TraceStats){.min = D_SIZE_MAX, .max = D_SIZE_MIN};
+
+    uint64_t end = first + count < reader->count ? first + count
+                                                  : reader->count;
+
+    if (first >= end)
+        return true;
+
+    int *cylinders = NULL;
+
+    for (uint32_t i = traceReaderFind(reader, first);
+         i < reader->blockCount && reader->blocks[i].first < end; i++)
+    {
+        const TraceBlock *block = &reader->blocks[i];
+        uint64_t blockEnd = block->first + block->stats.count;
+
+        // Whole blocks come straight from the index; only the blocks the
+        // range cuts through are decoded.
+        if (first <= block->first && blockEnd <= end)
+        {
+            traceStatsMerge(stats, &block->stats);
+            continue;
+        }
+
+        if (cylinders == NULL)
+            cylinders = safe_malloc(sizeof(int) * reader->blockLength);
+
+        if (traceReaderBlock(reader, i, cylinders) < 0)
+        {
+            free(cylinders);
+            return false;
+        }
+
+        uint64_t from = first > block->first ? first - block->first : 0;
+        uint64_t to = (blockEnd < end ? blockEnd : end) - block->first;
+
+        for (uint64_t j = from; j < to; j++)
+            traceStatsAdd(stats, cylinders[j]);
+    }
+
+    free(cylinders);
+
+    return true;
+}
+
+void traceReaderClose(TraceReader *reader)
+{
+    free(reader->blocks);
+    free(reader->buffer);
+    reader->blocks = NULL;
+    reader->buffer = NULL;
+}
+
+void traceStatsAdd(TraceStats *stats, const int cylinder)
+{
+    stats->count++;
+    stats->min = min(stats->min, cylinder);
+    stats->max = cylinder > stats->max ? cylinder : stats->max;
+    stats->sum += cylinder;
+    stats->sumOfSquares += (uint64_t)cylinder * cylinder;
+}
+
+void traceStatsMerge(TraceStats *stats, const TraceStats *other)
+{
+    if (other->count == 0)
+        return;
+
+    stats->count += other->count;
+    stats->min = min(stats->min, other->min);
+    stats->max = other->max > stats->max ? other->max : stats->max;
+    stats->sum += other->sum;
+    stats->sumOfSquares += other->sumOfSquares;
+}
+
+size_t encodeDeltas(const int cylinders[], const int count, uint8_t *out)
+{
+    size_t length = 0;
+    int previous = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int delta = cylinders[i] - previous;
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+        // LEB128: seven bits at a time, high bit set while more follow
+        while (zigzag >= CONTINUATION)
+        {
+            out[length++] = zigzag | CONTINUATION;
+            zigzag >>= 7;
+        }
+        out[length++] = zigzag;
+
+        previous = cylinders[i];
+    }
+
+    return length;
+}
+
+size_t decodeDeltas(const uint8_t *bytes, const size_t length,
+                    int cylinders[], const int count)
+{
+    const uint8_t *p = bytes;
+    const uint8_t *end = bytes + length;
+    int previous = 0;
+    int i = 0;
+
+    while (i < count && p < end)
+    {
+        // Fast path: when the next eight bytes are all single-byte varints
+        // (deltas within ±63, the common case for sequential runs), take
+        // them as one word instead of byte by byte.
+        if (end - p >= 8 && count - i >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, p, 8);
+
+            if ((word & ALL_CONTINUATIONS) == 0)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    uint32_t zigzag = (word >> (8 * k)) & 0xff;
+                    previous += (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+                    cylinders[i++] = previous;
+                }
+
+                p += 8;
+                continue;
+            }
+        }
+
+        uint32_t zigzag = 0;
+        int shift = 0;
+
+        do
+        {
+            if (p == end || shift > 7 * (TRACE_MAX_VARINT - 1))
+                return i;
+
+            zigzag |= (uint32_t)(*p & ~CONTINUATION) << shift;
+            shift += 7;
+        } while (*p++ & CONTINUATION);
+
+        previous += (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+        cylinders[i++] = previous;
+    }
+
+    return i;
+}
+
+bool readCompressedTrace(FILE *in, RequestTable *requests)
+{
+    TraceReader reader;
+
+    if (!traceReaderOpen(&reader, in))
+        return false;
+
+    int *cylinders = safe_malloc(sizeof(int) * reader.blockLength);
+    int count;
+
+    while ((count = traceReaderNext(&reader, cylinders)) > 0)
+    {
+        for (int i = 0; i < count; i++)
+            requestTableAppend(requests, cylinders[i]);
+    }
+
+    free(cylinders);
+    traceReaderClose(&reader);
+
+    return count == 0;
+}
+
+bool convertTrace(const char *inPath, const char *outPath)
+{
+    FILE *in = fopen(inPath, "rb");
+
+    if (in == NULL)
+    {
+        fprintf(stderr, "Could not open file: %s\n", inPath);
+        return false;
+    }
+
+    // Opening the output truncates it, so it mustn't be the input.
+    struct stat inInfo;
+    struct stat outInfo;
+
+    if (fstat(fileno(in), &inInfo) == 0 && stat(outPath, &outInfo) == 0 &&
+        inInfo.st_dev == outInfo.st_dev && inInfo.st_ino == outInfo.st_ino)
+    {
+        fprintf(stderr, "Input and output are the same file: %s\n", outPath);
+        fclose(in);
+        return false;
+    }
+
+    FILE *out = fopen(outPath, "wb");
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "Could not open file: %s\n", outPath);
+        fclose(in);
+        return false;
+    }
+
+    bool ok;
+
+    if (isCompressedTrace(inPath))
+    {
+        // Compressed to text
+        TraceReader reader;
+        ok = traceReaderOpen(&reader, in);
+
+        if (ok)
+        {
+            int *cylinders = safe_malloc(sizeof(int) * reader.blockLength);
+            int count;
+
+            while ((count = traceReaderNext(&reader, cylinders)) > 0)
+            {
+                for (int i = 0; i < count; i++)
+                    fprintf(out, "%d\n", cylinders[i]);
+            }
+
+            ok = count == 0;
+            free(cylinders);
+            traceReaderClose(&reader);
+        }
+    }
+    else
+    {
+        // Text to compressed
+        RequestTable requests;
+        requestTableInit(&requests, D_DYNAMIC_BASE_SIZE);
+
+        if ((ok = readSeekFile(inPath, &requests)))
+        {
+            TraceWriter writer;
+            ok = traceWriterOpen(&writer, out);
+
+            for (long i = 0; ok && i < requests.length; i++)
+                traceWriterAdd(&writer, requests.cylinder[i]);
+
+            ok = traceWriterClose(&writer) && ok;
+        }
+
+        requestTableFree(&requests);
+    }
+
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+
+    return ok;
+}
+
+bool simulateCompressed(const char *path)
+{
+    FILE *in = fopen(path, "rb");
+
+    if (in == NULL)
+    {
+        fprintf(stderr, "Could not open file: %s\n", path);
+        return false;
+    }
+
+    TraceReader reader;
+
+    if (!traceReaderOpen(&reader, in))
+    {
+        fclose(in);
+        return false;
+    }
+
+    Simulation sim;
+    simulationInit(&sim);
+    writerStart(&sim);
+
+    // Blocks are decoded straight into the chunking.
+    int *cylinders = safe_malloc(sizeof(int) * reader.blockLength);
+    int count;
+
+    while ((count = traceReaderNext(&reader, cylinders)) > 0)
+    {
+        for (int i = 0; i < count; i++)
+            simulationFeed(&sim, cylinders[i]);
+    }
+
+    if (count == 0)
+        simulationFinish(&sim);
+    else
+    {
+        writerStop(&sim);
+        simulationFree(&sim);
+    }
+
+    free(cylinders);
+    traceReaderClose(&reader);
+    fclose(in);
+
+    return count == 0;
+}
+
+bool printTraceStats(const char *path, const uint64_t first,
+                     const uint64_t count)
+{
+    FILE *in = fopen(path, "rb");
+
+    if (in == NULL)
+    {
+        fprintf(stderr, "Could not open file: %s\n", path);
+        return false;
+    }
+
+    TraceReader reader;
+
+    if (!traceReaderOpen(&reader, in))
+    {
+        fclose(in);
+        return false;
+    }
+
+    TraceStats stats;
+    bool ok = traceReaderStats(&reader, first, count, &stats);
+
+    if (ok)
+    {
+        double n = stats.count;
+        double mean = stats.sum / n;
+        double variance = (stats.sumOfSquares - stats.sum * mean) / n;
+
+        printHeader("Overview");
+        printf(
+            "Total requested seeks: %llu\n"
+            "Mean: %.4f\n"
+            "Standard deviation: %.4f\n"
+            "Lowest cylinder: %d\n"
+            "Highest cylinder: %d\n",
+            (unsigned long long)stats.count, stats.count ? mean : 0.0,
+            stats.count && variance > 0 ? sqrt(variance) : 0.0,
+            stats.count ? stats.min : 0, stats.count ? stats.max : 0);
+    }
+
+    traceReaderClose(&reader);
+    fclose(in);
+
+    return ok;
+}
+
+static void flushBlock(TraceWriter *writer)
+{
+    if (writer->blockCount == writer->blockCapacity)
+    {
+        writer->blockCapacity *= 2;
+        writer->blocks = safe_realloc(
+            writer->blocks, sizeof(TraceBlock) * writer->blockCapacity);
+    }
+
+    // Blocks start over from zero so each decodes on its own.
+    uint32_t bytes =
+        encodeDeltas(writer->pending, writer->pendingLength, writer->buffer);
+
+    TraceBlock *block = &writer->blocks[writer->blockCount++];
+    *block = (TraceBlock){
+        .offset = ftell(writer->out),
+        .first = writer->count - writer->pendingLength,
+        .bytes = bytes,
+        .stats = {.min = D_SIZE_MAX, .max = D_SIZE_MIN},
+    };
+
+    for (uint32_t i = 0; i < writer->pendingLength; i++)
+        traceStatsAdd(&block->stats, writer->pending[i]);
+
+    fwrite(writer->buffer, 1, bytes, writer->out);
+    writer->pendingLength = 0;
+}
+
+static void putU32(uint8_t *bytes, const uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        bytes[i] = value >> (8 * i);
+}
+
+static void putU64(uint8_t *bytes, const uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        bytes[i] = value >> (8 * i);
+}
+
+static uint32_t getU32(const uint8_t *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= (uint32_t)bytes[i] << (8 * i);
+    return value;
+}
+
+static uint64_t getU64(const uint8_t *bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t)bytes[i] << (8 * i);
+    return value;
+}
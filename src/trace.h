@@ -0,0 +1,114 @@
+/**
+ * Compressed trace format
+ *
+ * Cylinders are stored as zig-zag encoded deltas packed into varints, in
+ * independent blocks of TRACE_BLOCK_LENGTH requests so that any block can
+ * be decoded on its own. A block index at the end of the file records
+ * where each block starts, which request it starts at, and a summary of
+ * its cylinders, so a reader can jump straight to any request and answer
+ * overview statistics without decoding.
+ *
+ * Layout (all integers little-endian):
+ *   header   magic "DASZ", version, block length, block count,
+ *            request count, index offset
+ *   blocks   varint deltas, each block starting from cylinder zero
+ *   index    per block: byte offset, first request, byte length,
+ *            request count, min, max, sum, sum of squares
+ *
+ * @file trace.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "dass.h"
+#include "requests.h"
+
+#define TRACE_MAGIC "DASZ"
+#define TRACE_VERSION 2
+#define TRACE_BLOCK_LENGTH 4096
+
+// Largest block length a reader will accept from a file's header
+#define TRACE_BLOCK_LENGTH_MAX (1 << 20)
+
+// Zig-zag deltas of 16-bit cylinders never need more than three bytes.
+#define TRACE_MAX_VARINT 3
+
+typedef struct TraceStats
+{
+    uint64_t count;
+    int min;
+    int max;
+    uint64_t sum;
+    uint64_t sumOfSquares;
+} TraceStats;
+
+typedef struct TraceBlock
+{
+    uint64_t offset;
+    uint64_t first;
+    uint32_t bytes;
+    TraceStats stats;
+} TraceBlock;
+
+typedef struct TraceWriter
+{
+    FILE *out;
+    uint32_t blockLength;
+    uint64_t count;
+
+    int *pending;
+    uint32_t pendingLength;
+    uint8_t *buffer;
+
+    TraceBlock *blocks;
+    uint32_t blockCount;
+    uint32_t blockCapacity;
+} TraceWriter;
+
+typedef struct TraceReader
+{
+    FILE *in;
+    uint32_t blockLength;
+    uint64_t count;
+    uint32_t blockCount;
+    TraceBlock *blocks;
+
+    uint8_t *buffer;
+    uint32_t next;
+} TraceReader;
+
+bool isCompressedTrace(const char *path);
+
+bool traceWriterOpen(TraceWriter *writer, FILE *out);
+void traceWriterAdd(TraceWriter *writer, const int cylinder);
+bool traceWriterClose(TraceWriter *writer);
+
+bool traceReaderOpen(TraceReader *reader, FILE *in);
+int traceReaderNext(TraceReader *reader, int cylinders[]);
+int traceReaderBlock(TraceReader *reader, const uint32_t block,
+                     int cylinders[]);
+uint32_t traceReaderFind(const TraceReader *reader, const uint64_t request);
+bool traceReaderStats(TraceReader *reader, const uint64_t first,
+                      const uint64_t count, TraceStats *stats);
+void traceReaderClose(TraceReader *reader);
+
+void traceStatsAdd(TraceStats *stats, const int cylinder);
+void traceStatsMerge(TraceStats *stats, const TraceStats *other);
+
+size_t encodeDeltas(const int cylinders[], const int count, uint8_t *out);
+size_t decodeDeltas(const uint8_t *bytes, const size_t length,
+                    int cylinders[], const int count);
+
+bool readCompressedTrace(FILE *in, RequestTable *requests);
+bool convertTrace(const char *inPath, const char *outPath);
+bool simulateCompressed(const char *path);
+bool printTraceStats(const char *path, const uint64_t first,
+                     const uint64_t count);
+
+#endif
@@ -0,0 +1,401 @@
+/**
+ * Differential testing of the fast schedulers
+ *
+ * @file verify.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dass.h"
+#include "fastsched.h"
+#include "verify.h"
+
+// Minimum time spent on each throughput measurement
+#define VERIFY_TIMING_SECONDS 0.2
+
+typedef void (*Schedule)(Simulation *sim, SchedulerState *state,
+                         SeekList *seeks);
+
+typedef struct Engine
+{
+    const char *key;
+    Schedule reference;
+    Schedule fast;
+} Engine;
+
+typedef enum Workload
+{
+    WORKLOAD_UNIFORM,
+    WORKLOAD_NARROW,
+    WORKLOAD_EDGES,
+    WORKLOAD_MIRRORED,
+    WORKLOAD_SORTED,
+    WORKLOAD_REVERSED,
+    WORKLOADS
+} Workload;
+
+// Everything a chunk is scheduled from
+typedef struct Case
+{
+    Simulation sim;
+    SchedulerState state;
+    int *seeks;
+    int length;
+} Case;
+
+// What a chunk left behind
+typedef struct Outcome
+{
+    Simulation sim;
+    SchedulerState state;
+    int *order;
+} Outcome;
+
+static const Engine engines[] = {
+    {"sstf", shortestSeekFirst, fastShortestSeekFirst},
+    {"elevator", elevatorAlgorithm, fastElevatorAlgorithm},
+};
+
+#define ENGINES ((int)(sizeof(engines) / sizeof(engines[0])))
+
+static const int chunkSizes[] = {0, 1, 2, 3, 4, 5, 8, 20, 33, 64, 257, 1000};
+
+#define CHUNK_SIZES ((int)(sizeof(chunkSizes) / sizeof(chunkSizes[0])))
+
+static void generate(int seeks[], const int length, const int start);
+static void randomCase(Case *test, int seeks[]);
+static void run(const Schedule schedule, const Case *test, Outcome *outcome);
+static bool differs(const Case *test, const Outcome *reference,
+                    const Outcome *fast);
+static bool fails(const Engine *engine, const Case *test);
+static void shrink(const Engine *engine, Case *test);
+static void report(const Engine *engine, const Case *test);
+static double timeEngine(const Schedule schedule, const int seeks[],
+                         const int chunkSize, const int total);
+
+bool verifySchedulers(const int rounds, const unsigned seed)
+{
+    srand(seed);
+
+    printHeader("Differential verification");
+    printf("Seed: %u\n", seed);
+    printf("Rounds: %d\n\n", rounds);
+
+    const int capacity = chunkSizes[CHUNK_SIZES - 1];
+    int *seeks = safe_malloc(sizeof(int) * capacity);
+    int *referenceOrder = safe_malloc(sizeof(int) * capacity);
+    int *fastOrder = safe_malloc(sizeof(int) * capacity);
+
+    bool ok = true;
+
+    for (int e = 0; e < ENGINES && ok; e++)
+    {
+        const Engine *engine = &engines[e];
+        long chunks = 0;
+        long requests = 0;
+
+        for (int round = 0; round < rounds && ok; round++)
+        {
+            Case test;
+            randomCase(&test, seeks);
+
+            // Later chunks start from wherever the reference left off.
+            int count = randint(1, VERIFY_CHUNKS_MAX);
+
+            for (int chunk = 0; chunk < count && ok; chunk++)
+            {
+                Outcome reference = {.order = referenceOrder};
+                Outcome fast = {.order = fastOrder};
+
+                run(engine->reference, &test, &reference);
+                run(engine->fast, &test, &fast);
+
+                chunks++;
+                requests += test.length;
+
+                if (differs(&test, &reference, &fast))
+                {
+                    ok = false;
+                    shrink(engine, &test);
+                    report(engine, &test);
+                    break;
+                }
+
+                test.sim = reference.sim;
+                test.state = reference.state;
+                test.length = chunkSizes[randint(0, CHUNK_SIZES - 1)];
+                generate(seeks, test.length, test.state.start);
+            }
+        }
+
+        if (ok)
+        {
+            printf("%s: %ld chunks, %ld requests, all matched\n", engine->key,
+                   chunks, requests);
+        }
+    }
+
+    if (ok)
+    {
+        printHeader("Throughput");
+
+        const int sizes[] = {20, 32, 160, 1000, 4096};
+        const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+        const int total = 1 << 16;
+        int *data = safe_malloc(sizeof(int) * total);
+
+        for (int i = 0; i < total; i++)
+            data[i] = randint(D_SIZE_MIN, D_SIZE_MAX);
+
+        for (int e = 0; e < ENGINES; e++)
+        {
+            for (int s = 0; s < sizeCount; s++)
+            {
+                double reference =
+                    timeEngine(engines[e].reference, data, sizes[s], total);
+                double fast =
+                    timeEngine(engines[e].fast, data, sizes[s], total);
+
+                printf("%s (chunks of %d): %.1f ns reference, %.1f ns fast "
+                       "per request (%.2fx)\n",
+                       engines[e].key, sizes[s], reference, fast,
+                       reference / fast);
+            }
+        }
+
+        free(data);
+    }
+
+    printf("\n");
+
+    free(seeks);
+    free(referenceOrder);
+    free(fastOrder);
+
+    return ok;
+}
+
+static void generate(int seeks[], const int length, const int start)
+{
+    Workload workload = randint(0, WORKLOADS - 1);
+
+    // Narrow ranges make duplicates and equidistant ties common.
+    int width = randint(1, 16);
+    int base = randint(D_SIZE_MIN, D_SIZE_MAX - width);
+
+    for (int i = 0; i < length; i++)
+    {
+        int seek;
+
+        switch (workload)
+        {
+        case WORKLOAD_NARROW:
+            seek = base + randint(0, width - 1);
+            break;
+        case WORKLOAD_EDGES:
+            seek = randint(0, 1) ? randint(D_SIZE_MIN, D_SIZE_MIN + 2)
+                                 : randint(D_SIZE_MAX - 2, D_SIZE_MAX);
+            break;
+        case WORKLOAD_MIRRORED:
+            seek = start + (randint(0, 1) ? 1 : -1) * randint(0, width);
+            if (seek < D_SIZE_MIN || seek > D_SIZE_MAX)
+                seek = start;
+            break;
+        default:
+            seek = randint(D_SIZE_MIN, D_SIZE_MAX);
+            break;
+        }
+
+        seeks[i] = seek;
+    }
+
+    // Already-ordered input is where insertion-style shortcuts go wrong.
+    for (int i = 1; workload >= WORKLOAD_SORTED && i < length; i++)
+    {
+        int value = seeks[i];
+        int j = i - 1;
+
+        for (; j >= 0 && (workload == WORKLOAD_SORTED ? seeks[j] > value
+                                                      : seeks[j] < value);
+             j--)
+        {
+            seeks[j + 1] = seeks[j];
+        }
+
+        seeks[j + 1] = value;
+    }
+}
+
+static void randomCase(Case *test, int seeks[])
+{
+    simulationInit(&test->sim);
+    test->sim.quiet = true;
+    test->sim.elevatorPolicy = randint(ELEVATOR_UP, ELEVATOR_DENSER);
+
+    // Sometimes carry on from a sweep already under way.
+    if (randint(0, 1))
+    {
+        test->sim.elevatorStarted = true;
+        test->sim.elevatorUp = randint(0, 1);
+    }
+
+    const int starts[] = {D_SIZE_MIN, D_SIZE_MAX, D_POS_INIT};
+
+    test->state = (SchedulerState){
+        .start = randint(0, 1) ? starts[randint(0, 2)]
+                               : randint(D_SIZE_MIN, D_SIZE_MAX),
+        .distance = randint(0, 1) ? 0 : randint(1, 1000),
+    };
+
+    test->seeks = seeks;
+    test->length = chunkSizes[randint(0, CHUNK_SIZES - 1)];
+    generate(seeks, test->length, test->state.start);
+
+    // Requests sitting right under the head
+    if (test->length > 0 && randint(0, 3) == 0)
+        seeks[randint(0, test->length - 1)] = test->state.start;
+}
+
+static void run(const Schedule schedule, const Case *test, Outcome *outcome)
+{
+    outcome->sim = test->sim;
+    outcome->state = test->state;
+    memcpy(outcome->order, test->seeks, sizeof(int) * test->length);
+
+    SeekList seeks = {outcome->order, test->length};
+    schedule(&outcome->sim, &outcome->state, &seeks);
+}
+
+static bool differs(const Case *test, const Outcome *reference,
+                    const Outcome *fast)
+{
+    return memcmp(reference->order, fast->order,
+                  sizeof(int) * test->length) != 0 ||
+           reference->state.start != fast->state.start ||
+           reference->state.tally != fast->state.tally ||
+           reference->state.distance != fast->state.distance ||
+           memcmp(reference->state.buckets, fast->state.buckets,
+                  sizeof(reference->state.buckets)) != 0 ||
+           reference->sim.elevatorUp != fast->sim.elevatorUp ||
+           reference->sim.elevatorStarted != fast->sim.elevatorStarted ||
+           reference->sim.elevatorReversals != fast->sim.elevatorReversals;
+}
+
+static bool fails(const Engine *engine, const Case *test)
+{
+    int size = test->length > 0 ? test->length : 1;
+    Outcome reference = {.order = safe_malloc(sizeof(int) * size)};
+    Outcome fast = {.order = safe_malloc(sizeof(int) * size)};
+
+    run(engine->reference, test, &reference);
+    run(engine->fast, test, &fast);
+
+    bool failed = differs(test, &reference, &fast);
+
+    free(reference.order);
+    free(fast.order);
+
+    return failed;
+}
+
+static void shrink(const Engine *engine, Case *test)
+{
+    // Drop ever smaller runs of requests for as long as it still fails.
+    for (int span = test->length / 2; span > 0; span /= 2)
+    {
+        for (int at = 0; at + span <= test->length;)
+        {
+            Case smaller = *test;
+            int *seeks = safe_malloc(sizeof(int) * test->length);
+
+            memcpy(seeks, test->seeks, sizeof(int) * at);
+            memcpy(seeks + at, test->seeks + at + span,
+                   sizeof(int) * (test->length - at - span));
+            smaller.seeks = seeks;
+            smaller.length = test->length - span;
+
+            if (fails(engine, &smaller))
+            {
+                memcpy(test->seeks, seeks, sizeof(int) * smaller.length);
+                test->length = smaller.length;
+            }
+            else
+            {
+                at += span;
+            }
+
+            free(seeks);
+        }
+    }
+}
+
+static void report(const Engine *engine, const Case *test)
+{
+    int size = test->length > 0 ? test->length : 1;
+    Outcome outcomes[2] = {
+        {.order = safe_malloc(sizeof(int) * size)},
+        {.order = safe_malloc(sizeof(int) * size)},
+    };
+    const char *names[2] = {"Reference", "Fast"};
+
+    run(engine->reference, test, &outcomes[0]);
+    run(engine->fast, test, &outcomes[1]);
+
+    printf("%s: MISMATCH\n\n", engine->key);
+    printf("Starting position: %d\n", test->state.start);
+    printf("Distance so far: %ld\n", test->state.distance);
+    printf("Elevator: policy %d, %s, %s\n", test->sim.elevatorPolicy,
+           test->sim.elevatorStarted ? "started" : "not started",
+           test->sim.elevatorUp ? "up" : "down");
+    printf("Requests (%d): ", test->length);
+    printIntList(test->seeks, test->length);
+    printf("\n");
+
+    for (int i = 0; i < 2; i++)
+    {
+        const Outcome *outcome = &outcomes[i];
+
+        printf("%s: tally %d, distance %ld, final %d, %s, %d reversals\n",
+               names[i], outcome->state.tally, outcome->state.distance,
+               outcome->state.start, outcome->sim.elevatorUp ? "up" : "down",
+               outcome->sim.elevatorReversals);
+        printIntList(outcome->order, test->length);
+    }
+
+    free(outcomes[0].order);
+    free(outcomes[1].order);
+}
+
+static double timeEngine(const Schedule schedule, const int seeks[],
+                         const int chunkSize, const int total)
+{
+    Simulation sim;
+    simulationInit(&sim);
+    sim.quiet = true;
+
+    int *chunk = safe_malloc(sizeof(int) * chunkSize);
+    long requests = 0;
+    double began = monotonicSeconds();
+    double elapsed;
+
+    do
+    {
+        for (int at = 0; at + chunkSize <= total; at += chunkSize)
+        {
+            memcpy(chunk, seeks + at, sizeof(int) * chunkSize);
+
+            SeekList list = {chunk, chunkSize};
+            schedule(&sim, &sim.states[0], &list);
+            requests += chunkSize;
+        }
+
+        elapsed = monotonicSeconds() - began;
+    } while (elapsed < VERIFY_TIMING_SECONDS);
+
+    free(chunk);
+
+    return elapsed * 1e9 / requests;
+}
@@ -0,0 +1,25 @@
+/**
+ * Differential testing of the fast schedulers
+ *
+ * Runs each engine in fastsched.c against the original it replaces on
+ * randomly generated chunks (duplicates, ties, the edges of the disk and a
+ * spread of chunk sizes), carrying state from chunk to chunk the way a
+ * simulation does. Any difference in order, tally, distance or elevator
+ * state is shrunk to a small failing chunk and printed.
+ *
+ * @file verify.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "dass.h"
+
+#define VERIFY_ROUNDS 1000
+#define VERIFY_CHUNKS_MAX 4
+
+bool verifySchedulers(const int rounds, const unsigned seed);
+
+#endif
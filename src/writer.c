@@ -0,0 +1,285 @@
+/**
+ * Asynchronous output writer
+ *
+ * @file writer.c
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "dass.h"
+#include "spsc.h"
+#include "writer.h"
+
+// Marks the end of the results.
+static ChunkResult endOfResults;
+
+static void writerOpen(Writer *writer, const int fd);
+static void writerEmit(void *context, const ChunkResult *result);
+static void writerClose(Writer *writer);
+static void *writeResults(void *argument);
+static void flush(Writer *writer);
+static void writeAll(const int fd, const char *text, const size_t length);
+static void appendText(Writer *writer, const char *text, const size_t length);
+static void appendString(Writer *writer, const char *text);
+static void appendInt(Writer *writer, long value);
+static void appendHeader(Writer *writer, const char *title);
+static void appendOverview(Writer *writer, const ChunkResult *result);
+static void appendRunStats(Writer *writer, const int order[],
+                           const int length, const char *title,
+                           const int start);
+
+void writerStart(Simulation *sim)
+{
+    const char *setting = getenv("D_ASYNC_OUTPUT");
+
+    if (sim->quiet || sim->writer != NULL ||
+        (setting != NULL && streq(setting, "0")))
+    {
+        return;
+    }
+
+    sim->writer = safe_malloc(sizeof(Writer));
+    writerOpen(sim->writer, STDOUT_FILENO);
+
+    sim->emit = writerEmit;
+    sim->emitContext = sim->writer;
+}
+
+void writerStop(Simulation *sim)
+{
+    if (sim->writer == NULL)
+        return;
+
+    writerClose(sim->writer);
+    free(sim->writer);
+
+    sim->writer = NULL;
+    sim->emit = NULL;
+    sim->emitContext = NULL;
+}
+
+static void writerOpen(Writer *writer, const int fd)
+{
+    // Anything already printed goes out first.
+    fflush(stdout);
+
+    *writer = (Writer){
+        .fd = fd,
+        .interactive = isatty(fd),
+        .results = safe_malloc(sizeof(ChunkResult) * WRITER_RESULTS),
+        .buffer = safe_malloc(WRITER_BUFFER_SIZE),
+    };
+
+    spscInit(&writer->queue, WRITER_RESULTS);
+    spscInit(&writer->spare, WRITER_RESULTS);
+
+    for (int i = 0; i < WRITER_RESULTS; i++)
+        spscPush(&writer->spare, &writer->results[i]);
+
+    pthread_create(&writer->thread, NULL, writeResults, writer);
+}
+
+static void writerEmit(void *context, const ChunkResult *result)
+{
+    Writer *writer = context;
+
+    // Waits for a free record when the writer falls behind.
+    ChunkResult *copy = spscPop(&writer->spare);
+    *copy = *result;
+    spscPush(&writer->queue, copy);
+}
+
+static void writerClose(Writer *writer)
+{
+    spscPush(&writer->queue, &endOfResults);
+    pthread_join(writer->thread, NULL);
+
+    flush(writer);
+
+    spscFree(&writer->queue);
+    spscFree(&writer->spare);
+    free(writer->results);
+    free(writer->buffer);
+}
+
+static void *writeResults(void *argument)
+{
+    Writer *writer = argument;
+
+    for (;;)
+    {
+        void *item;
+
+        if (!spscTryPop(&writer->queue, &item))
+        {
+            // Caught up: a terminal gets what there is so far.
+            if (writer->interactive)
+                flush(writer);
+
+            item = spscPop(&writer->queue);
+        }
+
+        if (item == &endOfResults)
+            break;
+
+        const ChunkResult *result = item;
+
+        if (writer->length + WRITER_RECORD_MAX > WRITER_BUFFER_SIZE)
+            flush(writer);
+
+        appendOverview(writer, result);
+
+        for (int i = 0; i < schedulerCount; i++)
+        {
+            appendRunStats(writer, result->orders[i], result->length,
+                           schedulers[i].title, result->starts[i]);
+        }
+
+        spscPush(&writer->spare, item);
+    }
+
+    return NULL;
+}
+
+static void flush(Writer *writer)
+{
+    writeAll(writer->fd, writer->buffer, writer->length);
+    writer->length = 0;
+}
+
+static void writeAll(const int fd, const char *text, const size_t length)
+{
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t wrote = write(fd, text + done, length - done);
+
+        if (wrote < 0 && errno == EINTR)
+            continue;
+        if (wrote <= 0)
+            break;
+
+        done += wrote;
+    }
+}
+
+static void appendText(Writer *writer, const char *text, const size_t length)
+{
+    if (writer->length + length > WRITER_BUFFER_SIZE)
+    {
+        flush(writer);
+
+        if (length > WRITER_BUFFER_SIZE)
+        {
+            writeAll(writer->fd, text, length);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+}
+
+static void appendString(Writer *writer, const char *text)
+{
+    appendText(writer, text, strlen(text));
+}
+
+static void appendInt(Writer *writer, long value)
+{
+    char digits[24];
+    int i = sizeof(digits);
+    bool negative = value < 0;
+    unsigned long magnitude =
+        negative ? -(unsigned long)value : (unsigned long)value;
+
+    do
+    {
+        digits[--i] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (negative)
+        digits[--i] = '-';
+
+    appendText(writer, digits + i, sizeof(digits) - i);
+}
+
+static void appendHeader(Writer *writer, const char *title)
+{
+    // As printHeader()
+    appendString(writer, "\n");
+    appendString(writer, title);
+    appendString(writer, "\n");
+
+    for (int i = 0; title[i] != '\0'; i++)
+        appendString(writer, "=");
+
+    appendString(writer, "\n\n");
+}
+
+static void appendOverview(Writer *writer, const ChunkResult *result)
+{
+    // As printOverview(), down to the order of the arithmetic
+    long sum = 0;
+    for (int i = 0; i < result->length; i++)
+        sum += result->seeks[i];
+
+    double mean = sum / (double)result->length;
+
+    double sumOfDeviations = 0;
+    for (int i = 0; i < result->length; i++)
+    {
+        sumOfDeviations +=
+            (result->seeks[i] - mean) * (result->seeks[i] - mean);
+    }
+
+    double stddev = sqrt(sumOfDeviations / (double)result->length);
+
+    char line[128];
+    int length =
+        snprintf(line, sizeof(line),
+                 "Total requested seeks: %d\n"
+                 "Mean: %.4f\n"
+                 "Standard deviation: %.4f\n",
+                 result->length, mean, stddev);
+
+    appendHeader(writer, "Overview");
+    appendText(writer, line, length);
+}
+
+static void appendRunStats(Writer *writer, const int order[],
+                           const int length, const char *title,
+                           const int start)
+{
+    // As printRunStats()
+    int distance = 0;
+    int seekPosition = start;
+
+    for (int i = 0; i < length; i++)
+    {
+        distance += abs(order[i] - seekPosition);
+        seekPosition = order[i];
+    }
+
+    appendHeader(writer, title);
+    appendString(writer, "Starting position: ");
+    appendInt(writer, start);
+    appendString(writer, "\nTotal distance: ");
+    appendInt(writer, distance);
+    appendString(writer, "\n\n");
+
+    for (int i = 0; i < length; i++)
+    {
+        appendInt(writer, order[i]);
+        appendString(writer, i + 1 == length ? "\n" : ", ");
+    }
+}
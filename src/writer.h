@@ -0,0 +1,54 @@
+/**
+ * Asynchronous output writer
+ *
+ * Chunk results are handed to a writer thread through an SPSC queue, so
+ * the simulation never waits on formatting or on the terminal. The writer
+ * formats into one large buffer and writes it out with a single call once
+ * it fills (or, on a terminal, whenever it catches up). Results are
+ * written in the order they were emitted.
+ *
+ * A simulation given a writer with writerStart() sends it every chunk
+ * until writerStop(). D_ASYNC_OUTPUT=0 keeps printing on the simulation's
+ * own thread.
+ *
+ * @file writer.h
+ * @author Joseph Leskey <josleskey@mail.mvnu.edu>
+ * @date 1 April 2025
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <pthread.h>
+
+#include "dass.h"
+#include "spsc.h"
+
+#define WRITER_BUFFER_SIZE (1 << 20)
+#define WRITER_RESULTS 256
+
+// Room for one chunk's output with the built-in titles: headers, plus up
+// to sixteen characters per listed seek. The buffer is flushed before it
+// would hold less; anything longer (a plugin with a long title) flushes
+// part way through instead.
+#define WRITER_RECORD_MAX (1024 + SCHEDULERS_MAX * D_CHUNK_SIZE * 16)
+
+typedef struct Writer
+{
+    int fd;
+    bool interactive;
+
+    ChunkResult *results;
+    SpscQueue queue;
+    SpscQueue spare;
+
+    char *buffer;
+    size_t length;
+
+    pthread_t thread;
+} Writer;
+
+void writerStart(Simulation *sim);
+void writerStop(Simulation *sim);
+
+#endif